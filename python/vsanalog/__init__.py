@@ -3,9 +3,16 @@
 from __future__ import annotations
 
 import functools
+import multiprocessing
+import os
 import platform
+import runpy
+import shutil
 import sys
-from collections.abc import Callable, Sequence
+import tempfile
+from collections import deque
+from collections.abc import Callable, Iterator, Sequence
+from concurrent.futures import Future, ProcessPoolExecutor, ThreadPoolExecutor
 from importlib.metadata import version as _get_version
 from pathlib import Path
 from typing import Any, TypeVar
@@ -17,13 +24,27 @@ else:
 
 import vapoursynth as vs
 
-__all__ = ["decode_4fsc_video", "requires_plugin"]
+__all__ = [
+    "clear_source_cache",
+    "decode_4fsc_video",
+    "decode_many",
+    "iter_frames",
+    "render_sharded",
+    "requires_plugin",
+    "thumbnails",
+    "write_corrected_tbc",
+]
 
 __version__ = _get_version("vsanalog")
 
 P = ParamSpec("P")
 R = TypeVar("R")
 
+# Fewest frames render_sharded gives one process at a time. Each chunk's
+# first and last frames re-read the fields around them for the decoder's
+# look-behind/look-ahead, so short chunks waste reads.
+_MIN_SHARD_FRAMES = 250
+
 
 def _get_plugin_path() -> Path:
     """Derive the filesystem path of the bundled vsanalog shared library."""
@@ -72,15 +93,33 @@ def decode_4fsc_video(
     dropout_correct: bool = False,
     dropout_overcorrect: bool = False,
     dropout_intra: bool = False,
+    dropout_detect: int = 0,
     dropout_composite_or_luma_extra_sources: Sequence[str | Path] | None = None,
     dropout_chroma_extra_sources: Sequence[str | Path] | None = None,
     fpsnum: int | None = None,
     fpsden: int = 1,
-) -> vs.VideoNode:
+    cache: bool = False,
+    ivtc: str | None = None,
+    reuse_repeats: bool = False,
+    field_output: bool = False,
+    output_format: str | None = None,
+    matrix: str | None = None,
+    crop_left: int = 0,
+    crop_top: int = 0,
+    crop_right: int = 0,
+    crop_bottom: int = 0,
+    outputs: Sequence[str] | None = None,
+    metadata: str | Path | None = None,
+    threads: int = 1,
+    frame_metrics: bool = False,
+    motion_skip: float = 0.0,
+) -> vs.VideoNode | list[vs.VideoNode]:
     """Decode 4𝑓𝑠𝑐 (four times subcarrier frequency) digitized analog video.
 
     Reads time-base corrected (TBC) captures produced by ld-decode or vhs-decode
-    and returns a VapourSynth clip in YUV444PS or GRAYS format (32-bit float).
+    and returns a VapourSynth clip in YUV444PS or GRAYS format (32-bit float),
+    or in RGBS/RGB24 when requested with *output_format*. With several
+    *outputs*, returns a list of clips in that order.
     """
     kwargs: dict[str, Any] = {}
 
@@ -101,6 +140,16 @@ def decode_4fsc_video(
     if fpsnum is not None:
         kwargs["fpsnum"] = fpsnum
         kwargs["fpsden"] = fpsden
+    if ivtc is not None:
+        kwargs["ivtc"] = ivtc
+    if output_format is not None:
+        kwargs["output_format"] = output_format
+    if matrix is not None:
+        kwargs["matrix"] = matrix
+    if outputs is not None:
+        kwargs["outputs"] = outputs
+    if metadata is not None:
+        kwargs["metadata"] = metadata
 
     # VapourSynth's Python bindings handle bool→int and Path→str
     # coercion automatically, so remaining args pass through as-is.
@@ -116,5 +165,263 @@ def decode_4fsc_video(
         dropout_correct=dropout_correct,
         dropout_overcorrect=dropout_overcorrect,
         dropout_intra=dropout_intra,
+        dropout_detect=dropout_detect,
+        cache=cache,
+        reuse_repeats=reuse_repeats,
+        field_output=field_output,
+        crop_left=crop_left,
+        crop_top=crop_top,
+        crop_right=crop_right,
+        crop_bottom=crop_bottom,
+        threads=threads,
+        frame_metrics=frame_metrics,
+        motion_skip=motion_skip,
+        **kwargs,
+    )
+
+
+@requires_plugin
+def decode_many(
+    sources: Sequence[str | Path | Sequence[str | Path]],
+    *,
+    max_workers: int | None = None,
+    **opts: Any,
+) -> list[vs.VideoNode | list[vs.VideoNode]]:
+    """Open many captures at once with :func:`decode_4fsc_video`.
+
+    Each item of *sources* is a TBC path, or a sequence of the paths
+    ``decode_4fsc_video`` takes positionally (luma, chroma or Pb, Pr). All
+    are opened with the same keyword *opts* on up to *max_workers* threads
+    (default: one per CPU), so metadata parsing, JSON conversion and VBI
+    scans overlap. Returns the clips in the order of *sources*; the first
+    failure is raised after all opens finish.
+    """
+    items = [
+        (item,) if isinstance(item, (str, Path)) else tuple(item) for item in sources
+    ]
+    if max_workers is None:
+        max_workers = os.cpu_count() or 1
+    max_workers = max(1, min(max_workers, len(items)))
+
+    # Pool threads have no VapourSynth environment of their own. Opening in
+    # the caller's puts the clips in its core, which under vspipe, vsscript
+    # or vspreview is the script's rather than the process-wide one.
+    env = vs.get_current_environment()
+
+    def open_in_caller_env(paths: tuple[str | Path, ...]) -> Any:
+        with env.use():
+            return decode_4fsc_video(*paths, **opts)
+
+    with ThreadPoolExecutor(max_workers=max_workers) as pool:
+        opened = [pool.submit(open_in_caller_env, paths) for paths in items]
+    return [clip.result() for clip in opened]
+
+
+@requires_plugin
+def write_corrected_tbc(
+    source: str | Path,
+    output: str | Path,
+    extra_sources: Sequence[str | Path] | None = None,
+    *,
+    dropout_overcorrect: bool = False,
+    dropout_intra: bool = False,
+    dropout_detect: int = 0,
+    threads: int = 0,
+) -> dict[str, int]:
+    """Write a dropout-corrected copy of a TBC capture.
+
+    Streams *source* through dropout correction (using *extra_sources* for
+    multi-source correction) and writes the corrected TBC to *output* along
+    with a metadata sidecar listing only the dropouts that could not be
+    corrected. Returns counts of rewritten frames and corrected/failed
+    dropouts.
+    """
+    kwargs: dict[str, Any] = {}
+    if extra_sources is not None:
+        kwargs["extra_sources"] = extra_sources
+
+    return vs.core.analog.write_corrected_tbc(
+        source,
+        output,
+        dropout_overcorrect=dropout_overcorrect,
+        dropout_intra=dropout_intra,
+        dropout_detect=dropout_detect,
+        threads=threads,
         **kwargs,
     )
+
+
+@requires_plugin
+def thumbnails(
+    source: str | Path,
+    *,
+    interval: int = 120,
+    width: int = 128,
+    threads: int = 0,
+    cache: bool = True,
+    metadata: str | Path | None = None,
+) -> vs.VideoNode:
+    """Return a clip of small luma thumbnails of every *interval*-th frame.
+
+    Thumbnails are built from the raw TBC samples by background workers and
+    saved next to the metadata sidecar, so reopening an unchanged capture
+    loads them at once. Each frame's ``AnalogSourceFrame`` property holds the
+    TBC frame it shows.
+    """
+    kwargs: dict[str, Any] = {}
+    if metadata is not None:
+        kwargs["metadata"] = metadata
+
+    return vs.core.analog.thumbnails(
+        source,
+        interval=interval,
+        width=width,
+        threads=threads,
+        cache=cache,
+        **kwargs,
+    )
+
+
+@requires_plugin
+def clear_source_cache() -> None:
+    """Release all sources kept by ``decode_4fsc_video(..., cache=True)``."""
+    vs.core.analog.clear_source_cache()
+
+
+def iter_frames(
+    clip: vs.VideoNode,
+    prefetch: int | None = None,
+    *,
+    start: int = 0,
+    end: int | None = None,
+) -> Iterator[vs.VideoFrame]:
+    """Yield the frames of *clip* in order, decoding ahead of the consumer.
+
+    Keeps *prefetch* frame requests in flight (default: the core's thread
+    count), so decoders stay busy while the caller processes each frame.
+    Requests are only made as frames are consumed, bounding memory use to
+    *prefetch* frames. Frames from *start* up to (not including) *end* are
+    yielded; a failed frame raises when it is reached.
+    """
+    if prefetch is None:
+        prefetch = vs.core.num_threads
+    if prefetch < 1:
+        raise ValueError("prefetch must be at least 1")
+    end = clip.num_frames if end is None else min(end, clip.num_frames)
+    if start < 0 or start > end:
+        raise ValueError(f"start must be between 0 and {end}")
+
+    def request(n: int) -> Future[vs.VideoFrame]:
+        future: Future[vs.VideoFrame] = Future()
+
+        def on_done(frame: vs.VideoFrame | None, error: Any) -> None:
+            if error is not None:
+                if not isinstance(error, BaseException):
+                    error = vs.Error(str(error))
+                future.set_exception(error)
+            else:
+                future.set_result(frame)
+
+        clip.get_frame_async(n, on_done)
+        return future
+
+    pending: deque[Future[vs.VideoFrame]] = deque()
+    next_request = start
+    while next_request < end and len(pending) < prefetch:
+        pending.append(request(next_request))
+        next_request += 1
+
+    while pending:
+        frame = pending.popleft().result()
+        # Replace the request before handing the frame over, so that
+        # *prefetch* requests stay in flight while the caller works
+        if next_request < end:
+            pending.append(request(next_request))
+            next_request += 1
+        yield frame
+
+
+def _load_clip(script_or_callable: str | Path | Callable[[], vs.VideoNode]) -> vs.VideoNode:
+    """Evaluate a VapourSynth script (output 0) or clip factory."""
+    if callable(script_or_callable):
+        return script_or_callable()
+    runpy.run_path(str(script_or_callable), run_name="__vapoursynth__")
+    output = vs.get_output(0)
+    return output.clip if hasattr(output, "clip") else output
+
+
+def _render_shard(
+    script_or_callable: str | Path | Callable[[], vs.VideoNode],
+    start: int,
+    end: int,
+    path: str,
+    y4m: bool,
+    threads: int,
+) -> int:
+    """Render frames [start, end) of a clip to a file in a worker process."""
+    vs.core.num_threads = threads
+    clip = _load_clip(script_or_callable)
+    with open(path, "wb") as f:
+        clip[start:end].output(f, y4m=y4m)
+    return end - start
+
+
+def render_sharded(
+    script_or_callable: str | Path | Callable[[], vs.VideoNode],
+    output: str | Path,
+    *,
+    workers: int | None = None,
+    y4m: bool | None = None,
+) -> int:
+    """Render a clip across several processes into one output file.
+
+    *script_or_callable* is a VapourSynth script (its output 0 is rendered)
+    or a picklable, module-level function returning the clip. The frame
+    range is split into chunks rendered by *workers* processes (default: one
+    per CPU), each evaluating the clip itself, and the chunks are joined in
+    order into *output* as raw planar frames, or as Y4M when *y4m* is set
+    (default: when *output* ends in ``.y4m``). Frames are identical to a
+    single-process render. Returns the number of frames written.
+    """
+    output = Path(output)
+    if workers is None:
+        workers = os.cpu_count() or 1
+    if workers < 1:
+        raise ValueError("workers must be at least 1")
+    if y4m is None:
+        y4m = output.suffix.lower() == ".y4m"
+
+    # Evaluating the clip here first also converts any JSON metadata to the
+    # SQLite sidecar the workers then share, instead of each converting it
+    num_frames = _load_clip(script_or_callable).num_frames
+    if not callable(script_or_callable):
+        vs.clear_outputs()
+
+    # A few chunks per worker even out uneven frame costs
+    chunk = max(_MIN_SHARD_FRAMES, -(-num_frames // (workers * 4)))
+    ranges = [(start, min(start + chunk, num_frames)) for start in range(0, num_frames, chunk)]
+    workers = max(1, min(workers, len(ranges)))
+    threads = max(1, (os.cpu_count() or 1) // workers)
+
+    shard_dir = tempfile.mkdtemp(prefix=".vsanalog-shards-", dir=output.parent)
+    try:
+        shard_paths = [os.path.join(shard_dir, f"{i:06d}") for i in range(len(ranges))]
+        # VapourSynth cores don't survive fork(); workers start fresh
+        context = multiprocessing.get_context("spawn")
+        with ProcessPoolExecutor(max_workers=workers, mp_context=context) as pool:
+            shards = [
+                pool.submit(_render_shard, script_or_callable, start, end, path, y4m, threads)
+                for (start, end), path in zip(ranges, shard_paths)
+            ]
+            written = sum(shard.result() for shard in shards)
+
+        with open(output, "wb") as out:
+            for i, path in enumerate(shard_paths):
+                with open(path, "rb") as shard:
+                    if y4m and i > 0:
+                        shard.readline()  # Only the first stream header is kept
+                    shutil.copyfileobj(shard, out)
+    finally:
+        shutil.rmtree(shard_dir, ignore_errors=True)
+
+    return written
@@ -6,13 +6,144 @@
  ******************************************************************************/
 
 #include "analog4fsc.h"
+#include "autotune.h"
 #include "tbcreader.h"
 #include "componentframe.h"
+#include "framemetrics.h"
+#include "halffloat.h"
 
+#include <QDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
 #include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Autotuning tries up to this many decode threads. Each holds a decoder's
+// working memory, which is large for transform3d.
+constexpr int MAX_AUTOTUNE_THREADS = 16;
+
+// Frames each decode thread decodes per autotuning trial
+constexpr int AUTOTUNE_FRAMES_PER_THREAD = 4;
+
+// The fewest threads reaching this share of the best measured rate win,
+// as more contexts cost memory for little gain
+constexpr double AUTOTUNE_TOLERANCE = 0.95;
+
+// Sources calibrating at once (e.g. from decode_many) would skew each other
+std::mutex autotuneMutex;
+
+// Y′CbCr to R′G′B′ for the SMPTE 170M / BT.470 / BT.601 luma coefficients
+// our Y′CbCr output uses (Kr = 0.299, Kb = 0.114), with Cb/Cr in [-0.5, 0.5]
+constexpr double KR_601 = 0.299;
+constexpr double KB_601 = 0.114;
+constexpr double KR_709 = 0.2126;
+constexpr double KB_709 = 0.0722;
+
+void ycbcrToRgbMatrix(double kR, double kB, double (&m)[3][3]) {
+    const double kG = 1.0 - kR - kB;
+    m[0][0] = 1.0; m[0][1] = 0.0;                             m[0][2] = 2.0 * (1.0 - kR);
+    m[1][0] = 1.0; m[1][1] = -2.0 * (1.0 - kB) * kB / kG;    m[1][2] = -2.0 * (1.0 - kR) * kR / kG;
+    m[2][0] = 1.0; m[2][1] = 2.0 * (1.0 - kB);                m[2][2] = 0.0;
+}
+
+void rgbToYcbcrMatrix(double kR, double kB, double (&m)[3][3]) {
+    const double kG = 1.0 - kR - kB;
+    m[0][0] = kR;                        m[0][1] = kG;                        m[0][2] = kB;
+    m[1][0] = -kR / (2.0 * (1.0 - kB));  m[1][1] = -kG / (2.0 * (1.0 - kB));  m[1][2] = 0.5;
+    m[2][0] = 0.5;                       m[2][1] = -kG / (2.0 * (1.0 - kR));  m[2][2] = -kB / (2.0 * (1.0 - kR));
+}
+
+// Apply a 3x3 matrix to a row of Y′CbCr samples
+void matrixRowToFloat(const float *y, const float *cb, const float *cr,
+                      const float (&m)[3][3],
+                      float *out0, float *out1, float *out2, int width) {
+    for (int x = 0; x < width; x++) {
+        out0[x] = m[0][0] * y[x] + m[0][1] * cb[x] + m[0][2] * cr[x];
+        out1[x] = m[1][0] * y[x] + m[1][1] * cb[x] + m[1][2] * cr[x];
+        out2[x] = m[2][0] * y[x] + m[2][1] * cb[x] + m[2][2] * cr[x];
+    }
+}
+
+// Apply a 3x3 matrix to a row of Y′CbCr samples, storing full-range 8-bit
+// samples (0.0-1.0 to 0-255, clamped)
+void matrixRowToU8(const float *y, const float *cb, const float *cr,
+                   const float (&m)[3][3],
+                   uint8_t *out0, uint8_t *out1, uint8_t *out2, int width) {
+    auto quantize = [](float v) {
+        return static_cast<uint8_t>(std::clamp(v * 255.0f + 0.5f, 0.0f, 255.0f));
+    };
+    for (int x = 0; x < width; x++) {
+        out0[x] = quantize(m[0][0] * y[x] + m[0][1] * cb[x] + m[0][2] * cr[x]);
+        out1[x] = quantize(m[1][0] * y[x] + m[1][1] * cb[x] + m[1][2] * cr[x]);
+        out2[x] = quantize(m[2][0] * y[x] + m[2][1] * cb[x] + m[2][2] * cr[x]);
+    }
+}
+
+// Output frames whose luma block averages are kept for the next frame's
+// lumaDiff, beyond one per decode context (frames may finish slightly out
+// of order)
+constexpr size_t RECENT_BLOCK_MEANS = 4;
+
+// Output luma of a row of decoded Y, normalized to [0, 1] between the black
+// and white levels
+inline void normalizeDecodedLuma(const double *src, float *dst, int count,
+                                 double offset, double scale) {
+    for (int x = 0; x < count; x++) {
+        dst[x] = static_cast<float>((src[x] - offset) * scale);
+    }
+}
+
+// Output samples of a row of a component TBC, normalized like decoded luma
+inline void normalizeSamples(const quint16 *src, float *dst, int count,
+                             float offset, float scale) {
+    for (int x = 0; x < count; x++) {
+        dst[x] = (static_cast<float>(src[x]) - offset) * scale;
+    }
+}
+
+bool isRgbFormat(VSAnalogOutputFormat format) {
+    return format == VSAnalogOutputFormat::RGBS || format == VSAnalogOutputFormat::RGB24;
+}
+
+// Add one decode's dropout correction statistics to the caller's, or only
+// those of field fieldSeqNo when a single field is output
+void addStats(DropoutCorrectionStats *stats, const DropoutCorrectionStats &add,
+              qint32 fieldSeqNo = -1) {
+    if (!stats) return;
+    if (fieldSeqNo >= 0) {
+        stats->addField(add, fieldSeqNo);
+    } else {
+        stats->add(add);
+    }
+}
+
+} // anonymous namespace
+
+struct VSAnalog4fscSource::DecodedFrame {
+    int frameNumber = -1;  // Video frame, or -1 when the buffers hold none
+    ComponentFrame lumaFrame;
+    ComponentFrame chromaFrame;
+    SourceField fields[2][2];  // Luma and chroma field pairs, for auxiliary planes
+    DropoutCorrectionStats stats;
+    QVector<DropoutSpan> unresolved;
+};
+
+struct VSAnalog4fscSource::DecodeContext {
+    std::unique_ptr<TbcReader> ownedReaders[3];  // Empty for the first context
+    TbcReader *readers[3] = {};  // Luma/composite, chroma (or Pb) and Pr; null if absent
+    DecodedFrame decoded;
+};
 
 VSAnalog4fscSource::VSAnalog4fscSource(const std::filesystem::path &sourcePath,
                                         const std::filesystem::path *chromaSourcePath,
+                                        const std::filesystem::path *prSourcePath,
                                         const VSAnalog4fscOptions *opts)
     : reader(std::make_unique<TbcReader>())
 {
@@ -26,8 +157,35 @@ VSAnalog4fscSource::VSAnalog4fscSource(const std::filesystem::path &sourcePath,
         config.reverseFields = opts->reverseFields;
         config.phaseCompensation = opts->phaseCompensation;
         config.dropoutCorrect = opts->dropoutCorrect;
+        dropoutCorrect = opts->dropoutCorrect;
         config.dropoutOvercorrect = opts->dropoutOvercorrect;
         config.dropoutIntra = opts->dropoutIntra;
+        config.correctedFrameCacheSize = opts->correctedFrameCacheSize;
+        config.dropoutDetect = opts->dropoutDetect;
+        config.ivtcVbi = opts->ivtcVbi;
+        config.cropLeft = opts->cropLeft;
+        config.cropTop = opts->cropTop;
+        config.cropRight = opts->cropRight;
+        config.cropBottom = opts->cropBottom;
+        config.metadataPath = opts->metadataPath;
+        config.motionSkip = opts->motionSkip;
+        maxContexts = opts->decodeThreads > 0
+            ? opts->decodeThreads
+            : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        paddingMultiple = opts->paddingMultiple;
+        reverseFields = opts->reverseFields;
+        fieldOutput = opts->fieldOutput;
+        outputFormat = opts->outputFormat;
+        matrixBT709 = opts->matrixBT709;
+        if (matrixBT709 && isRgbFormat(outputFormat)) {
+            throw VSAnalogException("The BT.709 matrix only applies to YUV output");
+        }
+        if (fieldOutput && opts->ivtcVbi) {
+            throw VSAnalogException("Field output can't be combined with inverse telecine");
+        }
+        if (prSourcePath && opts->ivtcVbi) {
+            throw VSAnalogException("Inverse telecine isn't supported for component video");
+        }
         if (!opts->decoder.empty()) {
             config.decoder = TbcReader::parseDecoderName(
                 QString::fromStdString(opts->decoder));
@@ -41,6 +199,10 @@ VSAnalog4fscSource::VSAnalog4fscSource(const std::filesystem::path &sourcePath,
         // reseparate based on potentially-absent chroma in the luma source.
         lumaConfig.decoder = TbcReader::DecoderType::Mono;
     }
+    if (prSourcePath && chromaSourcePath && opts && !opts->decoder.empty()) {
+        qWarning() << "Component video is not chroma-decoded; ignoring decoder"
+                   << QString::fromStdString(opts->decoder);
+    }
 
     if (!reader->open(sourcePath, lumaConfig)) {
         throw VSAnalogException("Failed to open TBC file: " +
@@ -63,7 +225,9 @@ VSAnalog4fscSource::VSAnalog4fscSource(const std::filesystem::path &sourcePath,
         // vhs-decode emits a single shared sidecar for the luma TBC and none
         // for the chroma TBC; fall back to the luma metadata when the chroma
         // source has no sidecar of its own.
-        if (!chromaReader->open(*chromaSourcePath, config, reader->getMetadataDbPath())) {
+        // Component Pb is read raw like luma; the decoder is never run on it
+        const TbcReader::Configuration &chromaConfig = prSourcePath ? lumaConfig : config;
+        if (!chromaReader->open(*chromaSourcePath, chromaConfig, reader->getMetadataDbPath())) {
             throw VSAnalogException("Failed to open chroma TBC file: " +
                                     chromaReader->getLastError().toStdString());
         }
@@ -88,6 +252,32 @@ VSAnalog4fscSource::VSAnalog4fscSource(const std::filesystem::path &sourcePath,
         }
     }
 
+    // Open the Pr source for component video (Pb is the chroma source).
+    // All three TBCs are read raw, without chroma demodulation.
+    if (prSourcePath) {
+        if (!chromaReader) {
+            throw VSAnalogException("Component video needs a Pb source along with the Pr source");
+        }
+        prReader = std::make_unique<TbcReader>();
+        if (!prReader->open(*prSourcePath, lumaConfig, reader->getMetadataDbPath())) {
+            throw VSAnalogException("Failed to open Pr TBC file: " +
+                                    prReader->getLastError().toStdString());
+        }
+        if (reader->getWidth() != prReader->getWidth() ||
+            reader->getHeight() != prReader->getHeight() ||
+            reader->getFieldWidth() != prReader->getFieldWidth() ||
+            reader->getFieldWidth() != chromaReader->getFieldWidth()) {
+            throw VSAnalogException("Y, Pb and Pr TBC files have mismatched dimensions");
+        }
+        if (reader->getNumFrames() != prReader->getNumFrames()) {
+            throw VSAnalogException("Y and Pr TBC files have different frame counts");
+        }
+        if (prReader->getWhite16bIre() - prReader->getBlack16bIre() == 0.0) {
+            throw VSAnalogException("Pr TBC metadata has a zero IRE range "
+                                    "(white16bIre == black16bIre); check the metadata sidecar");
+        }
+    }
+
     // Guard against a zero IRE excursion (white == black), which would make the
     // luma/chroma scale factors infinite. This usually means the metadata
     // sidecar is missing its levels or failed to parse.
@@ -102,10 +292,213 @@ VSAnalog4fscSource::VSAnalog4fscSource(const std::filesystem::path &sourcePath,
     }
 
     initProperties();
+    initOutputMatrix();
+
+    // Pipes are read by one reader, so their frames are decoded one at a time
+    if (maxContexts > 1 && (reader->isPipe() || (chromaReader && chromaReader->isPipe()) ||
+                            (prReader && prReader->isPipe()))) {
+        qInfo() << "Pipe input is decoded one frame at a time";
+        maxContexts = 1;
+    }
+    auto firstContext = std::make_unique<DecodeContext>();
+    firstContext->readers[0] = reader.get();
+    firstContext->readers[1] = chromaReader.get();
+    firstContext->readers[2] = prReader.get();
+    idleContexts.push_back(std::move(firstContext));
+    numContexts = 1;
+
+    // Autotuned threads are calibrated once per host and decode setup
+    if (opts && opts->decodeThreads < 0 && maxContexts > 1) {
+        const auto &vp = reader->getVideoParameters();
+        const std::string setupKey =
+            (opts->decoder.empty() ? std::string("auto") : opts->decoder) + "-" +
+            std::to_string(vp.fieldWidth) + "x" + std::to_string(vp.fieldHeight) + "-" +
+            (prReader ? "component" : chromaReader ? "yc" : "composite") + "-" +
+            std::to_string(static_cast<int>(outputFormat)) +
+            (dropoutCorrect ? "-doc" : "") + (opts->motionSkip > 0.0 ? "-motionskip" : "");
+        int tuned = VSAnalogAutotune::decodeThreads(setupKey);
+        if (tuned <= 0) {
+            tuned = calibrateDecodeThreads();
+            if (tuned > 0) {
+                VSAnalogAutotune::storeDecodeThreads(setupKey, tuned);
+            }
+        }
+        if (tuned > 0) {
+            maxContexts = tuned;
+            qInfo() << "Decoding up to" << maxContexts << "frames at once (autotuned)";
+        }
+    }
 }
 
 VSAnalog4fscSource::~VSAnalog4fscSource() = default;
 
+std::unique_ptr<VSAnalog4fscSource::DecodeContext> VSAnalog4fscSource::createContext() {
+    auto context = std::make_unique<DecodeContext>();
+    TbcReader *sourceReaders[3] = { reader.get(), chromaReader.get(), prReader.get() };
+    for (int i = 0; i < 3; i++) {
+        if (!sourceReaders[i]) continue;
+        context->ownedReaders[i] = sourceReaders[i]->createDecodeContext();
+        if (!context->ownedReaders[i]) {
+            throw VSAnalogException("Failed to open decode context: " +
+                                    sourceReaders[i]->getLastError().toStdString());
+        }
+        context->readers[i] = context->ownedReaders[i].get();
+    }
+    return context;
+}
+
+std::unique_ptr<VSAnalog4fscSource::DecodeContext> VSAnalog4fscSource::acquireContext(int videoFrame) {
+    std::unique_lock<std::mutex> lock(contextMutex);
+    contextReleased.wait(lock, [this]() {
+        return !idleContexts.empty() || numContexts < maxContexts;
+    });
+
+    if (!idleContexts.empty()) {
+        auto found = std::find_if(idleContexts.begin(), idleContexts.end(),
+            [videoFrame](const std::unique_ptr<DecodeContext> &context) {
+                return context->decoded.frameNumber == videoFrame;
+            });
+        if (found == idleContexts.end()) {
+            found = std::prev(idleContexts.end());
+        }
+        std::unique_ptr<DecodeContext> context = std::move(*found);
+        idleContexts.erase(found);
+        return context;
+    }
+
+    // Open the new context outside the lock, so other decodes can return
+    // theirs meanwhile
+    numContexts++;
+    lock.unlock();
+    try {
+        return createContext();
+    } catch (...) {
+        lock.lock();
+        numContexts--;
+        lock.unlock();
+        contextReleased.notify_one();
+        throw;
+    }
+}
+
+void VSAnalog4fscSource::releaseContext(std::unique_ptr<DecodeContext> context) {
+    {
+        std::lock_guard<std::mutex> lock(contextMutex);
+        idleContexts.push_back(std::move(context));
+    }
+    contextReleased.notify_one();
+}
+
+int VSAnalog4fscSource::calibrateDecodeThreads() {
+    std::lock_guard<std::mutex> autotuneLock(autotuneMutex);
+    const int maxThreads = maxContexts;
+
+    std::vector<int> candidates;
+    const int mostThreads = std::min(maxThreads, MAX_AUTOTUNE_THREADS);
+    for (int threads = 1; threads < mostThreads; threads *= 2) {
+        candidates.push_back(threads);
+    }
+    candidates.push_back(mostThreads);
+
+    // Each trial decodes frames no earlier trial did, so none is served
+    // from a decode or corrected-frame cache
+    const int step = fieldOutput ? 2 : 1;
+    const int numVideoFrames = static_cast<int>(properties.NumFrames / step);
+    int framesNeeded = 0;
+    for (int threads : candidates) {
+        framesNeeded += threads * AUTOTUNE_FRAMES_PER_THREAD;
+    }
+    if (numVideoFrames < framesNeeded) {
+        qInfo() << "Source is too short to autotune decode threads";
+        return 0;
+    }
+
+    const bool gray = properties.VF.ColorFamily == 1;
+    const int stride = properties.Width * (properties.VF.BitsPerSample / 8);
+    const size_t planeBytes = static_cast<size_t>(stride) * properties.Height;
+
+    std::vector<double> rates;
+    int nextStart = (numVideoFrames - framesNeeded) / 2;
+    for (int threads : candidates) {
+        // Open the trial's contexts before timing it
+        maxContexts = threads;
+        {
+            std::vector<std::unique_ptr<DecodeContext>> held;
+            try {
+                for (int i = 0; i < threads; i++) {
+                    held.push_back(acquireContext(-1));
+                }
+            } catch (const VSAnalogException &e) {
+                qWarning() << "Autotuning decode threads failed:" << e.what();
+                held.clear();
+            }
+            const bool opened = static_cast<int>(held.size()) == threads;
+            for (auto &context : held) {
+                releaseContext(std::move(context));
+            }
+            if (!opened) {
+                maxContexts = maxThreads;
+                return 0;
+            }
+        }
+
+        const int start = nextStart;
+        const int end = start + threads * AUTOTUNE_FRAMES_PER_THREAD;
+        nextStart = end;
+        std::atomic<int> nextFrame{start};
+        std::atomic<bool> failed{false};
+
+        const auto began = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back([&]() {
+                std::vector<uint8_t> planes(planeBytes * (gray ? 1 : 3));
+                uint8_t *uData = gray ? nullptr : planes.data() + planeBytes;
+                uint8_t *vData = gray ? nullptr : planes.data() + 2 * planeBytes;
+                for (int n = nextFrame++; n < end && !failed; n = nextFrame++) {
+                    try {
+                        if (!GetFrame(n * step, planes.data(), uData, vData, stride, stride, stride))
+                            failed = true;
+                    } catch (const std::exception &) {
+                        failed = true;
+                    }
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - began;
+
+        if (failed) {
+            qWarning() << "Autotuning decode threads failed to decode frames" << start << "-" << end - 1;
+            maxContexts = maxThreads;
+            return 0;
+        }
+        rates.push_back((end - start) / std::max(elapsed.count(), 1e-6));
+        qInfo() << "Autotuning:" << threads << "decode threads," << rates.back() << "fps";
+    }
+
+    const double bestRate = *std::max_element(rates.begin(), rates.end());
+    size_t chosen = 0;
+    while (rates[chosen] < AUTOTUNE_TOLERANCE * bestRate) {
+        chosen++;
+    }
+    maxContexts = candidates[chosen];
+
+    // Drop the contexts only other trials used
+    std::vector<std::unique_ptr<DecodeContext>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(contextMutex);
+        while (numContexts > maxContexts && !idleContexts.empty()) {
+            dropped.push_back(std::move(idleContexts.back()));
+            idleContexts.pop_back();
+            numContexts--;
+        }
+    }
+    return maxContexts;
+}
+
 bool VSAnalog4fscSource::IsMonoOutput() const {
     return reader->isMonoDecoder();
 }
@@ -119,6 +512,26 @@ bool VSAnalog4fscSource::IsNTSCLines() const {
     return (system == NTSC || system == PAL_M);
 }
 
+bool VSAnalog4fscSource::IsIvtc() const {
+    return reader->isIvtc();
+}
+
+std::vector<int> VSAnalog4fscSource::GetRepeatSourceFrames() const {
+    const QVector<qint32> sources = reader->getRepeatSourceFrames();
+    return std::vector<int>(sources.begin(), sources.end());
+}
+
+std::vector<std::filesystem::path> VSAnalog4fscSource::GetMetadataPaths() const {
+    std::vector<std::filesystem::path> paths;
+    for (const TbcReader *source : {reader.get(), chromaReader.get(), prReader.get()}) {
+        if (!source) continue;
+        for (const QString &path : source->getMetadataDbPaths()) {
+            paths.push_back(path.toStdString());
+        }
+    }
+    return paths;
+}
+
 bool VSAnalog4fscSource::IsWidescreen() const {
     return reader->isWidescreen();
 }
@@ -170,29 +583,56 @@ int VSAnalog4fscSource::GetActiveHeight() const {
 void VSAnalog4fscSource::initProperties() {
     // Set up video format based on decoder type
     // With separate chroma source, we always output YUV even if luma decoder is mono
-    if (reader->isMonoDecoder() && !chromaReader) {
-        // Mono decoder outputs grayscale (GRAYS format)
+    if (isRgbFormat(outputFormat)) {
+        // R′G′B′ output, even from mono decodes (R′ = G′ = B′)
+        properties.VF.ColorFamily = 2;  // RGB
+    } else if (reader->isMonoDecoder() && !chromaReader) {
+        // Mono decoder outputs grayscale (GRAYS/GRAYH format)
         properties.VF.ColorFamily = 1;  // Gray
     } else {
-        // Color decoders (or luma+chroma dual source) output YUV444PS
+        // Color decoders (or luma+chroma dual source) output YUV444PS/PH
         properties.VF.ColorFamily = 3;  // YUV
     }
-    properties.VF.SampleType = 1;       // Float
-    properties.VF.BitsPerSample = 32;
+    if (outputFormat == VSAnalogOutputFormat::RGB24) {
+        properties.VF.SampleType = 0;   // Integer
+        properties.VF.BitsPerSample = 8;
+    } else if (outputFormat == VSAnalogOutputFormat::YUV444PH) {
+        properties.VF.SampleType = 1;   // Float
+        properties.VF.BitsPerSample = 16;
+    } else {
+        properties.VF.SampleType = 1;   // Float
+        properties.VF.BitsPerSample = 32;
+    }
     properties.VF.SubSamplingW = 0;     // No subsampling
     properties.VF.SubSamplingH = 0;
 
     properties.Width = reader->getWidth();
     properties.Height = reader->getHeight();
+    if (fieldOutput) {
+        // The taller field of the active area, padded like frames are
+        properties.Height = (reader->getActiveHeight() + 1) / 2;
+        if (paddingMultiple > 0) {
+            properties.Height = ((properties.Height + paddingMultiple - 1) / paddingMultiple)
+                * paddingMultiple;
+        }
+    }
     properties.SSModWidth = properties.Width;
     properties.SSModHeight = properties.Height;
     properties.NumFrames = reader->getNumFrames();
     properties.NumRFFFrames = properties.NumFrames;  // No RFF support yet
+    // With VBI inverse telecine, the pulled-down video frame count
+    properties.NumSourceFrames = reader->getNumSourceFrames();
 
     // Set frame rate based on video system
     auto fps = reader->getFrameRate();
     properties.FPS.Num = fps.num;
     properties.FPS.Den = fps.den;
+    if (fieldOutput) {
+        properties.NumFrames *= 2;
+        properties.NumRFFFrames *= 2;
+        properties.NumSourceFrames *= 2;
+        properties.FPS.Num *= 2;
+    }
 
     // Duration in timebase units (1/fps)
     properties.TimeBase.Num = properties.FPS.Den;
@@ -200,41 +640,528 @@ void VSAnalog4fscSource::initProperties() {
     properties.Duration = properties.NumFrames;
 }
 
+void VSAnalog4fscSource::initOutputMatrix() {
+    // Identity (Y′CbCr passthrough) unless converting
+    double m[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+    if (isRgbFormat(outputFormat)) {
+        ycbcrToRgbMatrix(KR_601, KB_601, m);
+    } else if (matrixBT709) {
+        // Back to R′G′B′ with the source matrix, then forward with BT.709's
+        double toRgb[3][3];
+        double toYcbcr[3][3];
+        ycbcrToRgbMatrix(KR_601, KB_601, toRgb);
+        rgbToYcbcrMatrix(KR_709, KB_709, toYcbcr);
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                m[i][j] = 0.0;
+                for (int k = 0; k < 3; k++) {
+                    m[i][j] += toYcbcr[i][k] * toRgb[k][j];
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            outputMatrix[i][j] = static_cast<float>(m[i][j]);
+        }
+    }
+}
+
 void VSAnalog4fscSource::SetSeekPreRoll(int preroll) {
     seekPreRoll = preroll;
 }
 
-bool VSAnalog4fscSource::GetFrame(int frameNumber, float *yData, float *uData, float *vData,
+bool VSAnalog4fscSource::GetFrame(int frameNumber, uint8_t *yData, uint8_t *uData, uint8_t *vData,
                                   int yStride, int uStride, int vStride,
-                                  DropoutCorrectionStats *stats) {
-    std::lock_guard<std::mutex> lock(decodeMutex);
+                                  DropoutCorrectionStats *stats,
+                                  const VSAnalogAuxPlanes *aux,
+                                  FrameMetrics *metrics) {
+    const int videoFrame = fieldOutput ? frameNumber / 2 : frameNumber;
 
-    ComponentFrame lumaFrame;
-    if (!reader->decodeFrame(frameNumber, lumaFrame, stats)) {
-        return false;
+    // The context returns to the pool however the decode ends
+    struct ContextLease {
+        VSAnalog4fscSource *source;
+        std::unique_ptr<DecodeContext> context;
+        ~ContextLease() { source->releaseContext(std::move(context)); }
+    } lease{this, acquireContext(videoFrame)};
+    DecodeContext &context = *lease.context;
+
+    // The next frame's lumaDiff waits for this frame's block averages while
+    // it's under way, rather than decoding it again. Recorded only once a
+    // context is held, so a frame waited for is never waiting for one.
+    struct MeasuringFrame {
+        VSAnalog4fscSource *source = nullptr;
+        int frameNumber = -1;
+        ~MeasuringFrame() {
+            if (!source) return;
+            {
+                std::lock_guard<std::mutex> lock(source->blockMeansMutex);
+                source->measuringFrames.erase(source->measuringFrames.find(frameNumber));
+            }
+            source->blockMeansAdded.notify_all();
+        }
+    } measuring;
+    if (metrics) {
+        std::lock_guard<std::mutex> lock(blockMeansMutex);
+        measuringFrames.insert(frameNumber);
+        measuring = {this, frameNumber};
     }
 
-    // If we have a separate chroma source, decode from it too
-    if (chromaReader) {
-        ComponentFrame chromaFrame;
-        if (!chromaReader->decodeFrame(frameNumber, chromaFrame, stats)) {
+    if (prReader) {
+        return getComponentFrame(context, frameNumber, yData, uData, vData,
+                                 yStride, uStride, vStride, stats, aux, metrics);
+    }
+
+    // Decode into the buffers of the context's previous decode, which the
+    // readers swap with theirs, so frames don't allocate and fault in a
+    // fresh set of full-frame planes. In field output mode both fields of a
+    // frame come from one decode, so a field's partner (normally requested
+    // next) reuses it.
+    TbcReader *lumaReader = context.readers[0];
+    TbcReader *contextChromaReader = context.readers[1];
+    DecodedFrame &decoded = context.decoded;
+    if (decoded.frameNumber != videoFrame) {
+        decoded.frameNumber = -1;
+        decoded.stats = DropoutCorrectionStats();
+        decoded.unresolved.clear();
+        decoded.stats.unresolved = &decoded.unresolved;
+        if (!lumaReader->decodeFrame(videoFrame, decoded.lumaFrame, &decoded.stats,
+                                     decoded.fields[0])) {
             return false;
         }
-        convertToFloat(lumaFrame, &chromaFrame, yData, uData, vData, yStride, uStride, vStride);
-    } else {
-        convertToFloat(lumaFrame, nullptr, yData, uData, vData, yStride, uStride, vStride);
+        // If we have a separate chroma source, decode from it too
+        if (contextChromaReader &&
+            !contextChromaReader->decodeFrame(videoFrame, decoded.chromaFrame, &decoded.stats,
+                                              decoded.fields[1])) {
+            return false;
+        }
+        decoded.frameNumber = videoFrame;
+    }
+
+    // A field's own corrections, so summing over fields counts each once
+    const int fieldParity = fieldOutput ? frameNumber % 2 : -1;
+    addStats(stats, decoded.stats,
+             fieldParity >= 0 ? decoded.fields[0][fieldParity].field.seqNo : -1);
+
+    // Scaled samples are written straight into the caller's planes, with
+    // any metrics gathered from the luma rows on the way
+    std::unique_ptr<FrameMetricsAccumulator> accumulator;
+    if (metrics) {
+        accumulator = std::make_unique<FrameMetricsAccumulator>(
+            GetActiveWidth(), outputActiveHeight(fieldParity), fieldParity < 0);
+    }
+    convertOutput(decoded.lumaFrame, chromaReader ? &decoded.chromaFrame : nullptr,
+                  yData, uData, vData, yStride, uStride, vStride, fieldParity,
+                  accumulator.get());
+    if (metrics) {
+        finishMetrics(context, frameNumber, *accumulator, *metrics);
+    }
+    // Auxiliary planes are drawn from the decoded fields
+    if (aux && (aux->dropoutMask || aux->raw)) {
+        writeAuxPlanes(decoded.fields, chromaReader ? 2 : 1, decoded.stats, *aux, fieldParity);
+    }
+    return true;
+}
+
+bool VSAnalog4fscSource::getComponentFrame(DecodeContext &context, int frameNumber,
+                                           uint8_t *yData, uint8_t *uData, uint8_t *vData,
+                                           int yStride, int uStride, int vStride,
+                                           DropoutCorrectionStats *stats,
+                                           const VSAnalogAuxPlanes *aux,
+                                           FrameMetrics *metrics) {
+    const int videoFrame = fieldOutput ? frameNumber / 2 : frameNumber;
+
+    // Each plane has its own reader, so Pb and Pr are read and
+    // dropout-corrected on their own threads while Y is on this one
+    TbcReader *const (&readers)[3] = context.readers;
+    SourceField fields[3][2];
+    DropoutCorrectionStats planeStats[3];
+    QVector<DropoutSpan> planeUnresolved[3];
+    for (int p = 0; p < 3; p++) {
+        planeStats[p].unresolved = &planeUnresolved[p];
+    }
+    auto loadPlane = [&](int plane) {
+        return readers[plane]->loadCorrectedFields(videoFrame, fields[plane][0], fields[plane][1],
+                                                   &planeStats[plane]);
+    };
+    auto pbLoaded = std::async(std::launch::async, loadPlane, 1);
+    auto prLoaded = std::async(std::launch::async, loadPlane, 2);
+    bool loaded = loadPlane(0);
+    loaded = pbLoaded.get() && loaded;
+    loaded = prLoaded.get() && loaded;
+    if (!loaded) {
+        return false;
+    }
+
+    DropoutCorrectionStats frameStats;
+    QVector<DropoutSpan> unresolved;
+    frameStats.unresolved = &unresolved;
+    for (const DropoutCorrectionStats &planeStat : planeStats) {
+        addStats(&frameStats, planeStat);
+    }
+
+    if (reverseFields) {
+        for (auto &planeFields : fields) {
+            std::swap(planeFields[0], planeFields[1]);
+        }
+    }
+
+    const int fieldParity = fieldOutput ? frameNumber % 2 : -1;
+    addStats(stats, frameStats, fieldParity >= 0 ? fields[0][fieldParity].field.seqNo : -1);
+    std::unique_ptr<FrameMetricsAccumulator> accumulator;
+    if (metrics) {
+        accumulator = std::make_unique<FrameMetricsAccumulator>(
+            GetActiveWidth(), outputActiveHeight(fieldParity), fieldParity < 0);
+    }
+    convertComponent(fields, yData, uData, vData, yStride, uStride, vStride, fieldParity,
+                     accumulator.get());
+    if (metrics) {
+        finishMetrics(context, frameNumber, *accumulator, *metrics);
+    }
+    if (aux && (aux->dropoutMask || aux->raw)) {
+        writeAuxPlanes(fields, 3, frameStats, *aux, fieldParity);
     }
     return true;
 }
 
-void VSAnalog4fscSource::convertToFloat(const ComponentFrame &lumaFrame,
-                                        const ComponentFrame *chromaFrame,
-                                        float *yData, float *uData, float *vData,
-                                        int yStride, int uStride, int vStride) {
+int VSAnalog4fscSource::outputActiveHeight(int fieldParity) const {
+    const int firstActiveLine = reader->getFirstActiveFrameLine();
+    const int activeHeight = reader->getActiveHeight();
+    if (fieldParity < 0) return activeHeight;
+    const int firstLine = firstActiveLine + ((firstActiveLine % 2 != fieldParity) ? 1 : 0);
+    return (firstActiveLine + activeHeight - firstLine + 1) / 2;
+}
+
+void VSAnalog4fscSource::addBlockMeans(int frameNumber,
+                                       std::shared_ptr<const std::vector<float>> means) {
+    {
+        std::lock_guard<std::mutex> lock(blockMeansMutex);
+        const bool known = std::any_of(recentBlockMeans.begin(), recentBlockMeans.end(),
+            [frameNumber](const auto &entry) { return entry.first == frameNumber; });
+        if (!known) {
+            if (recentBlockMeans.size() >= RECENT_BLOCK_MEANS + static_cast<size_t>(maxContexts)) {
+                recentBlockMeans.pop_front();
+            }
+            recentBlockMeans.emplace_back(frameNumber, std::move(means));
+        }
+    }
+    blockMeansAdded.notify_all();
+}
+
+std::shared_ptr<const std::vector<float>> VSAnalog4fscSource::lumaBlockMeans(
+        DecodeContext &context, int frameNumber) {
+    {
+        // A frame being output on another context publishes its averages
+        // when it finishes (or fails); that context never waits for this one
+        std::unique_lock<std::mutex> lock(blockMeansMutex);
+        for (;;) {
+            for (const auto &entry : recentBlockMeans) {
+                if (entry.first == frameNumber) return entry.second;
+            }
+            if (measuringFrames.count(frameNumber) == 0) break;
+            blockMeansAdded.wait(lock);
+        }
+    }
+
+    // Not output recently (out-of-order requests, or the first frame after
+    // a seek): decode it and take the same rows as its output would
+    const int videoFrame = fieldOutput ? frameNumber / 2 : frameNumber;
+    const int fieldParity = fieldOutput ? frameNumber % 2 : -1;
+    int firstLine = reader->getFirstActiveFrameLine();
+    int lineStep = 1;
+    if (fieldParity >= 0) {
+        lineStep = 2;
+        firstLine += (firstLine % 2 != fieldParity) ? 1 : 0;
+    }
+    const int width = reader->getActiveWidth();
+    const int height = outputActiveHeight(fieldParity);
+    const int activeVideoStart = reader->getActiveVideoStart();
+
+    LumaBlockMeans blocks(width, height);
+    std::vector<float> row(width);
+    TbcReader &lumaReader = *context.readers[0];
+    if (prReader) {
+        SourceField fields[2];
+        if (!lumaReader.loadCorrectedFields(videoFrame, fields[0], fields[1])) {
+            return nullptr;
+        }
+        if (reverseFields) {
+            std::swap(fields[0], fields[1]);
+        }
+        const int fieldWidth = reader->getFieldWidth();
+        const float offset = static_cast<float>(reader->getBlack16bIre());
+        const float scale = static_cast<float>(
+            1.0 / (reader->getWhite16bIre() - reader->getBlack16bIre()));
+        for (int y = 0; y < height; y++) {
+            const int frameLine = firstLine + y * lineStep;
+            const quint16 *src = fields[frameLine % 2].data.constData()
+                + static_cast<ptrdiff_t>(frameLine / 2) * fieldWidth + activeVideoStart;
+            normalizeSamples(src, row.data(), width, offset, scale);
+            blocks.addRow(row.data());
+        }
+    } else {
+        ComponentFrame frame;
+        if (!lumaReader.decodeFrame(videoFrame, frame)) {
+            return nullptr;
+        }
+        const double yOffset = reader->getBlack16bIre();
+        const double yScale = 1.0 / (reader->getWhite16bIre() - yOffset);
+        for (int y = 0; y < height; y++) {
+            normalizeDecodedLuma(frame.y(firstLine + y * lineStep) + activeVideoStart,
+                                 row.data(), width, yOffset, yScale);
+            blocks.addRow(row.data());
+        }
+    }
+    auto means = std::make_shared<const std::vector<float>>(blocks.finish());
+    addBlockMeans(frameNumber, means);
+    return means;
+}
+
+void VSAnalog4fscSource::finishMetrics(DecodeContext &context, int frameNumber,
+                                       FrameMetricsAccumulator &accumulator,
+                                       FrameMetrics &metrics) {
+    std::vector<float> blockMeans;
+    accumulator.finish(metrics, blockMeans);
+    auto current = std::make_shared<const std::vector<float>>(std::move(blockMeans));
+    addBlockMeans(frameNumber, current);
+
+    // Fields are compared with the previous field of the same parity, as
+    // adjacent fields are a line apart
+    metrics.lumaDiff = -1.0;
+    const int previousFrame = frameNumber - (fieldOutput ? 2 : 1);
+    if (previousFrame < 0) return;
+    if (const auto previous = lumaBlockMeans(context, previousFrame)) {
+        metrics.lumaDiff = LumaBlockMeans::difference(*previous, *current);
+    }
+}
+
+void VSAnalog4fscSource::writeAuxPlanes(const SourceField (*fieldPairs)[2], int numPairs,
+                                        const DropoutCorrectionStats &frameStats,
+                                        const VSAnalogAuxPlanes &aux, int fieldParity) const {
     const int width = properties.Width;
     const int height = properties.Height;
     const int activeWidth = reader->getActiveWidth();
-    const int activeHeight = reader->getActiveHeight();
+    int activeHeight = reader->getActiveHeight();
+    const int activeVideoStart = reader->getActiveVideoStart();
+    const int firstActiveLine = reader->getFirstActiveFrameLine();
+
+    // Same line selection as convertOutput
+    int lineStep = 1;
+    int firstLine = firstActiveLine;
+    if (fieldParity >= 0) {
+        lineStep = 2;
+        firstLine += (firstActiveLine % 2 != fieldParity) ? 1 : 0;
+        activeHeight = (firstActiveLine + activeHeight - firstLine + 1) / 2;
+    }
+
+    if (aux.raw) {
+        // Frame line L is field line L / 2 of the first (even) or second field
+        const SourceField (&fields)[2] = fieldPairs[0];
+        const int fieldWidth = reader->getFieldWidth();
+        for (int y = 0; y < height; y++) {
+            auto *rawRow = reinterpret_cast<uint16_t *>(aux.raw + static_cast<ptrdiff_t>(y) * aux.rawStride);
+            int copied = 0;
+            if (y < activeHeight) {
+                const int frameLine = firstLine + y * lineStep;
+                const SourceVideo::Data &data = fields[frameLine % 2].data;
+                const qsizetype offset = static_cast<qsizetype>(frameLine / 2) * fieldWidth
+                    + activeVideoStart;
+                if (offset + activeWidth <= data.size()) {
+                    std::memcpy(rawRow, data.constData() + offset,
+                                static_cast<size_t>(activeWidth) * sizeof(uint16_t));
+                    copied = activeWidth;
+                }
+            }
+            std::fill(rawRow + copied, rawRow + width, uint16_t(0));
+        }
+    }
+
+    if (aux.dropoutMask) {
+        for (int y = 0; y < height; y++) {
+            std::memset(aux.dropoutMask + static_cast<ptrdiff_t>(y) * aux.dropoutMaskStride, 0,
+                        static_cast<size_t>(width));
+        }
+
+        // Mark samples [startx, endx) of a 1-based field line
+        auto mark = [&](int field, qint32 fieldLine, qint32 startx, qint32 endx, uint8_t value) {
+            const int lineOffset = (fieldLine - 1) * 2 + field - firstLine;
+            if (lineOffset < 0 || lineOffset % lineStep != 0) return;
+            const int y = lineOffset / lineStep;
+            if (y >= activeHeight) return;
+            uint8_t *maskRow = aux.dropoutMask + static_cast<ptrdiff_t>(y) * aux.dropoutMaskStride;
+            const int from = std::max(startx - activeVideoStart, 0);
+            const int to = std::min(endx - activeVideoStart, activeWidth);
+            for (int x = from; x < to; x++) {
+                maskRow[x] = std::max(maskRow[x], value);
+            }
+        };
+
+        // Listed dropouts were corrected unless correction is off or left
+        // them unresolved
+        const uint8_t listedValue = dropoutCorrect
+            ? VSAnalogAuxPlanes::MASK_CORRECTED : VSAnalogAuxPlanes::MASK_UNCORRECTED;
+        for (int p = 0; p < numPairs; p++) {
+            for (int f = 0; f < 2; f++) {
+                const DropOuts &dropOuts = fieldPairs[p][f].field.dropOuts;
+                for (qint32 i = 0; i < dropOuts.size(); i++) {
+                    mark(f, dropOuts.fieldLine(i), dropOuts.startx(i), dropOuts.endx(i),
+                         listedValue);
+                }
+            }
+        }
+        if (frameStats.unresolved) {
+            // The TBCs of a frame share field sequence numbers and geometry,
+            // so the first pair locates a span from any of them
+            for (const DropoutSpan &span : *frameStats.unresolved) {
+                for (int f = 0; f < 2; f++) {
+                    if (fieldPairs[0][f].field.seqNo == span.seqNo) {
+                        mark(f, span.fieldLine, span.startx, span.endx,
+                             VSAnalogAuxPlanes::MASK_UNCORRECTED);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void VSAnalog4fscSource::convertComponent(const SourceField (&fields)[3][2],
+                                          uint8_t *yData, uint8_t *uData, uint8_t *vData,
+                                          int yStride, int uStride, int vStride,
+                                          int fieldParity, FrameMetricsAccumulator *metrics) {
+    const int width = properties.Width;
+    const int height = properties.Height;
+    const int activeWidth = reader->getActiveWidth();
+    int activeHeight = reader->getActiveHeight();
+    const int bytesPerSample = properties.VF.BitsPerSample / 8;
+
+    // Per-plane geometry and levels. Y is normalized to [0, 1] between its
+    // black and white levels. Pb and Pr sit at their own black (blanking)
+    // level and span ±350 mV against the 700 mV luma excursion, so the same
+    // normalization gives [-0.5, 0.5].
+    TbcReader *readers[3] = { reader.get(), chromaReader.get(), prReader.get() };
+    struct Plane {
+        int firstLine;
+        int videoStart;
+        int fieldWidth;
+        float offset;
+        float scale;
+    } planes[3];
+    int lineStep = 1;
+    for (int p = 0; p < 3; p++) {
+        const TbcReader &planeReader = *readers[p];
+        planes[p].firstLine = planeReader.getFirstActiveFrameLine();
+        planes[p].videoStart = planeReader.getActiveVideoStart();
+        planes[p].fieldWidth = planeReader.getFieldWidth();
+        planes[p].offset = static_cast<float>(planeReader.getBlack16bIre());
+        planes[p].scale = static_cast<float>(
+            1.0 / (planeReader.getWhite16bIre() - planeReader.getBlack16bIre()));
+        if (fieldParity >= 0) {
+            planes[p].firstLine += (planes[p].firstLine % 2 != fieldParity) ? 1 : 0;
+        }
+    }
+    if (fieldParity >= 0) {
+        lineStep = 2;
+        activeHeight = (reader->getFirstActiveFrameLine() + activeHeight - planes[0].firstLine + 1) / 2;
+    }
+
+    // Rows are scaled straight into YUV444PS planes; other formats are
+    // staged and converted by storeRow
+    const bool staged = needsStaging(false);
+    std::vector<float> staging;
+    if (staged) {
+        staging.resize(static_cast<size_t>(activeWidth) * 6);
+    }
+    uint8_t *planeData[3] = { yData, uData, vData };
+    const int planeStrides[3] = { yStride, uStride, vStride };
+
+    for (int y = 0; y < height; y++) {
+        uint8_t *rows[3];
+        for (int p = 0; p < 3; p++) {
+            rows[p] = planeData[p] + static_cast<ptrdiff_t>(y) * planeStrides[p];
+        }
+
+        if (y >= activeHeight) {
+            // Vertical padding: black with neutral chroma is all-zero samples
+            for (uint8_t *row : rows) {
+                std::memset(row, 0, static_cast<size_t>(width) * bytesPerSample);
+            }
+            continue;
+        }
+
+        float *scaled[3];
+        for (int p = 0; p < 3; p++) {
+            // Frame line L is line L / 2 of the first field (even L) or the
+            // second field (odd L)
+            const int frameLine = planes[p].firstLine + y * lineStep;
+            const SourceField &field = fields[p][frameLine % 2];
+            const quint16 *src = field.data.constData()
+                + static_cast<ptrdiff_t>(frameLine / 2) * planes[p].fieldWidth
+                + planes[p].videoStart;
+
+            scaled[p] = staged ? staging.data() + static_cast<size_t>(activeWidth) * p
+                               : reinterpret_cast<float *>(rows[p]);
+            normalizeSamples(src, scaled[p], activeWidth, planes[p].offset, planes[p].scale);
+        }
+        if (metrics) {
+            metrics->addRow(scaled[0]);
+        }
+        if (staged) {
+            storeRow(scaled[0], scaled[1], scaled[2], false, rows[0], rows[1], rows[2],
+                     activeWidth, staging.data() + static_cast<size_t>(activeWidth) * 3);
+        }
+
+        // Horizontal padding
+        const size_t activeBytes = static_cast<size_t>(activeWidth) * bytesPerSample;
+        const size_t padBytes = static_cast<size_t>(width - activeWidth) * bytesPerSample;
+        for (uint8_t *row : rows) {
+            std::memset(row + activeBytes, 0, padBytes);
+        }
+    }
+}
+
+void VSAnalog4fscSource::storeRow(const float *rowY, const float *rowCb, const float *rowCr,
+                                  bool gray, uint8_t *yRow, uint8_t *uRow, uint8_t *vRow,
+                                  int count, float *scratch) const {
+    if (gray) {
+        // Gray half-precision output
+        floatToHalfRow(rowY, reinterpret_cast<uint16_t *>(yRow), count);
+    } else if (outputFormat == VSAnalogOutputFormat::YUV444PH) {
+        const float *out0 = rowY;
+        const float *out1 = rowCb;
+        const float *out2 = rowCr;
+        if (matrixBT709) {
+            float *matrixed0 = scratch;
+            float *matrixed1 = matrixed0 + count;
+            float *matrixed2 = matrixed1 + count;
+            matrixRowToFloat(rowY, rowCb, rowCr, outputMatrix,
+                             matrixed0, matrixed1, matrixed2, count);
+            out0 = matrixed0;
+            out1 = matrixed1;
+            out2 = matrixed2;
+        }
+        floatToHalfRow(out0, reinterpret_cast<uint16_t *>(yRow), count);
+        floatToHalfRow(out1, reinterpret_cast<uint16_t *>(uRow), count);
+        floatToHalfRow(out2, reinterpret_cast<uint16_t *>(vRow), count);
+    } else if (outputFormat == VSAnalogOutputFormat::RGB24) {
+        matrixRowToU8(rowY, rowCb, rowCr, outputMatrix, yRow, uRow, vRow, count);
+    } else {
+        matrixRowToFloat(rowY, rowCb, rowCr, outputMatrix,
+                         reinterpret_cast<float *>(yRow),
+                         reinterpret_cast<float *>(uRow),
+                         reinterpret_cast<float *>(vRow), count);
+    }
+}
+
+void VSAnalog4fscSource::convertOutput(const ComponentFrame &lumaFrame,
+                                       const ComponentFrame *chromaFrame,
+                                       uint8_t *yData, uint8_t *uData, uint8_t *vData,
+                                       int yStride, int uStride, int vStride,
+                                       int fieldParity, FrameMetricsAccumulator *metrics) {
+    const int width = properties.Width;
+    const int height = properties.Height;
+    const int activeWidth = reader->getActiveWidth();
+    int activeHeight = reader->getActiveHeight();
     const bool isMono = (uData == nullptr);
 
     // Active region offsets (ComponentFrame contains full field data)
@@ -292,57 +1219,106 @@ void VSAnalog4fscSource::convertToFloat(const ComponentFrame &lumaFrame,
     const int uvFirstActiveLine = chromaFrame ? chromaFirstActiveLine : firstActiveLine;
     const int uvActiveVideoStart = chromaFrame ? chromaActiveVideoStart : activeVideoStart;
 
-    for (int y = 0; y < height; y++) {
-        auto *yRow = reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(yData) + y * yStride);
+    // Output row y reads input line (first line + y * lineStep). For a
+    // single field, start at that field's first active line and step over
+    // the other field's lines.
+    int lineStep = 1;
+    int firstLine = firstActiveLine;
+    int uvFirstLine = uvFirstActiveLine;
+    if (fieldParity >= 0) {
+        lineStep = 2;
+        firstLine += (firstActiveLine % 2 != fieldParity) ? 1 : 0;
+        uvFirstLine += (uvFirstActiveLine % 2 != fieldParity) ? 1 : 0;
+        activeHeight = (firstActiveLine + activeHeight - firstLine + 1) / 2;
+    }
 
-        if (y < activeHeight) {
-            // Access ComponentFrame at the correct input line (with firstActiveLine offset)
-            const double *srcY = lumaFrame.y(firstActiveLine + y) + activeVideoStart;
+    // Gray output has no chroma planes; a mono decode has no chroma to read
+    const bool hasChroma = !isMono && (chromaFrame || !reader->isMonoDecoder());
 
-            for (int x = 0; x < activeWidth; x++) {
-                // Y: subtract yOffset and multiply by yScale, normalize to [0, 1]
-                yRow[x] = static_cast<float>((srcY[x] - yOffset) * yScale);
-            }
-            // Fill horizontal padding with black (Y=0)
-            for (int x = activeWidth; x < width; x++) {
-                yRow[x] = 0.0f;
-            }
-        } else {
-            // Fill vertical padding with black (Y=0)
-            for (int x = 0; x < width; x++) {
-                yRow[x] = 0.0f;
+    // Conversions to anything but native Y′CbCr float are fused into this
+    // pass: each row's Y′CbCr is staged in small cache-resident buffers and
+    // matrixed and/or narrowed to half precision straight into the output
+    // planes. (Re-matrixing gray is a no-op, so gray float stays direct.)
+    const bool fused = needsStaging(isMono);
+    std::vector<float> rowY, rowCb, rowCr;
+    std::vector<float> matrixed;  // Matrixed rows awaiting half conversion
+    if (fused) {
+        rowY.resize(activeWidth);
+        rowCb.resize(activeWidth);
+        rowCr.resize(activeWidth);
+        matrixed.resize(static_cast<size_t>(activeWidth) * 3);
+    }
+    const int bytesPerSample = properties.VF.BitsPerSample / 8;
+
+    for (int y = 0; y < height; y++) {
+        uint8_t *yRow = yData + static_cast<ptrdiff_t>(y) * yStride;
+        uint8_t *uRow = isMono ? nullptr : uData + static_cast<ptrdiff_t>(y) * uStride;
+        uint8_t *vRow = isMono ? nullptr : vData + static_cast<ptrdiff_t>(y) * vStride;
+
+        if (y >= activeHeight) {
+            // Fill vertical padding with black (all-zero samples are black
+            // with neutral chroma in every output format)
+            std::memset(yRow, 0, static_cast<size_t>(width) * bytesPerSample);
+            if (!isMono) {
+                std::memset(uRow, 0, static_cast<size_t>(width) * bytesPerSample);
+                std::memset(vRow, 0, static_cast<size_t>(width) * bytesPerSample);
             }
+            continue;
         }
 
-        // For color output, also convert U/V planes
-        if (!isMono) {
-            auto *uRow = reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(uData) + y * uStride);
-            auto *vRow = reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(vData) + y * vStride);
+        // Access ComponentFrame at the correct input line (with firstActiveLine offset)
+        const double *srcY = lumaFrame.y(firstLine + y * lineStep) + activeVideoStart;
+        // Get chroma from the appropriate source
+        // (separate chroma TBC or same TBC as luma)
+        const double *srcU = hasChroma
+            ? uvSourceFrame.u(uvFirstLine + y * lineStep) + uvActiveVideoStart : nullptr;
+        const double *srcV = hasChroma
+            ? uvSourceFrame.v(uvFirstLine + y * lineStep) + uvActiveVideoStart : nullptr;
 
-            if (y < activeHeight) {
-                // Get chroma from the appropriate source
-                // (separate chroma TBC or same TBC as luma)
-                const double *srcU = uvSourceFrame.u(uvFirstActiveLine + y) + uvActiveVideoStart;
-                const double *srcV = uvSourceFrame.v(uvFirstActiveLine + y) + uvActiveVideoStart;
+        if (!fused) {
+            auto *yOut = reinterpret_cast<float *>(yRow);
+            normalizeDecodedLuma(srcY, yOut, activeWidth, yOffset, yScale);
+            if (metrics) {
+                metrics->addRow(yOut);
+            }
 
+            // For color output, also convert U/V planes
+            if (!isMono) {
+                auto *uOut = reinterpret_cast<float *>(uRow);
+                auto *vOut = reinterpret_cast<float *>(vRow);
                 for (int x = 0; x < activeWidth; x++) {
                     // Cb/Cr: multiply by scale to normalize to approximately
                     // [-0.5, 0.5]
-                    uRow[x] = static_cast<float>(srcU[x] * cbScale);
-                    vRow[x] = static_cast<float>(srcV[x] * crScale);
+                    uOut[x] = static_cast<float>(srcU[x] * cbScale);
+                    vOut[x] = static_cast<float>(srcV[x] * crScale);
                 }
-                // Fill horizontal padding with neutral chroma (U=V=0)
-                for (int x = activeWidth; x < width; x++) {
-                    uRow[x] = 0.0f;
-                    vRow[x] = 0.0f;
-                }
-            } else {
-                // Fill vertical padding with neutral chroma (U=V=0)
-                for (int x = 0; x < width; x++) {
-                    uRow[x] = 0.0f;
-                    vRow[x] = 0.0f;
+            }
+        } else {
+            normalizeDecodedLuma(srcY, rowY.data(), activeWidth, yOffset, yScale);
+            if (metrics) {
+                metrics->addRow(rowY.data());
+            }
+            if (hasChroma) {
+                for (int x = 0; x < activeWidth; x++) {
+                    rowCb[x] = static_cast<float>(srcU[x] * cbScale);
+                    rowCr[x] = static_cast<float>(srcV[x] * crScale);
                 }
+            } else if (!isMono) {
+                std::fill(rowCb.begin(), rowCb.end(), 0.0f);
+                std::fill(rowCr.begin(), rowCr.end(), 0.0f);
             }
+
+            storeRow(rowY.data(), rowCb.data(), rowCr.data(), isMono,
+                     yRow, uRow, vRow, activeWidth, matrixed.data());
+        }
+
+        // Fill horizontal padding with black
+        const size_t activeBytes = static_cast<size_t>(activeWidth) * bytesPerSample;
+        const size_t padBytes = static_cast<size_t>(width - activeWidth) * bytesPerSample;
+        std::memset(yRow + activeBytes, 0, padBytes);
+        if (!isMono) {
+            std::memset(uRow + activeBytes, 0, padBytes);
+            std::memset(vRow + activeBytes, 0, padBytes);
         }
     }
 }
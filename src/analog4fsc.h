@@ -8,15 +8,21 @@
 #ifndef ANALOG4FSC_H
 #define ANALOG4FSC_H
 
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <vector>
 #include <cstdint>
 
 class TbcReader;
 class ComponentFrame;
+class SourceField;
 struct DropoutCorrectionStats;
+struct FrameMetrics;
+class FrameMetricsAccumulator;
 
 // Video format description
 struct VSAnalogVideoFormat {
@@ -44,11 +50,32 @@ struct VSAnalogVideoProperties {
     int SSModHeight;   // Height rounded to subsampling multiple
     int64_t NumFrames;
     int64_t NumRFFFrames;  // Number of frames with RFF applied
+    int64_t NumSourceFrames;  // Video frames in the TBC (differs with ivtcVbi)
     VSAnalogRational FPS;
     int64_t Duration;
     VSAnalogRational TimeBase;
 };
 
+// Output sample formats
+enum class VSAnalogOutputFormat {
+    YUV444PS,  // Y′CbCr (or gray), 32-bit float
+    YUV444PH,  // Y′CbCr (or gray), 16-bit (half) float
+    RGBS,      // R′G′B′, 32-bit float
+    RGB24,     // R′G′B′, 8-bit full range
+};
+
+// Planes drawn from the source fields of a decode, returned alongside the
+// video with its dimensions. Planes left null aren't written.
+struct VSAnalogAuxPlanes {
+    static constexpr uint8_t MASK_CORRECTED = 128;
+    static constexpr uint8_t MASK_UNCORRECTED = 255;
+
+    uint8_t *dropoutMask = nullptr;  // 8-bit: 0, or MASK_* over dropouts of any TBC
+    int dropoutMaskStride = 0;
+    uint8_t *raw = nullptr;          // 16-bit composite (or luma/Y) samples as decoded
+    int rawStride = 0;
+};
+
 // Decode options
 struct VSAnalog4fscOptions {
     double chromaGain = 1.0;
@@ -61,6 +88,19 @@ struct VSAnalog4fscOptions {
     bool dropoutCorrect = false;   // Enable dropout correction
     bool dropoutOvercorrect = false; // Extend dropout boundaries (±24 samples)
     bool dropoutIntra = false;     // Intra-field only correction
+    int correctedFrameCacheSize = 0; // Recently corrected frames kept for reuse (0 = off)
+    int dropoutDetect = 0;         // Signal-based dropout detection (0 = off, 1 = auto, 2 = always)
+    bool ivtcVbi = false;          // Inverse telecine using VBI picture numbers
+    bool fieldOutput = false;      // One output frame per field (double rate)
+    VSAnalogOutputFormat outputFormat = VSAnalogOutputFormat::YUV444PS;
+    bool matrixBT709 = false;      // Re-matrix Y′CbCr output to BT.709 (YUV formats)
+    int cropLeft = 0;              // Active-area crop, applied inside the decode
+    int cropTop = 0;
+    int cropRight = 0;
+    int cropBottom = 0;
+    double motionSkip = 0.0;       // Moving-block share above which 3D decoders decode a frame in 2D (0 = off)
+    int decodeThreads = 1;         // Frames decoded at once, each by its own decode context (0 = one per CPU thread, -1 = autotuned)
+    std::filesystem::path metadataPath; // Metadata sidecar for the TBCs (empty = found by TBC name)
     std::vector<std::filesystem::path> dropoutExtraLumaSources;   // Extra TBC sources for multi-source DO correction
     std::vector<std::filesystem::path> dropoutExtraChromaSources; // Extra chroma TBC sources (for color-under formats)
     std::string decoder;           // Decoder name (empty = auto)
@@ -75,9 +115,11 @@ public:
 // Main 4FSC source class
 class VSAnalog4fscSource {
 public:
-    // Single source (composite) or dual source (luma + chroma from separate TBCs)
+    // Single source (composite), dual source (luma + chroma from separate
+    // TBCs) or component video (Y + Pb + Pr TBCs, with Pb as the chroma source)
     VSAnalog4fscSource(const std::filesystem::path &sourcePath,
                        const std::filesystem::path *chromaSourcePath,
+                       const std::filesystem::path *prSourcePath,
                        const VSAnalog4fscOptions *opts);
     ~VSAnalog4fscSource();
 
@@ -97,6 +139,23 @@ public:
     // Check if video system frame layout is NTSC (or PAL-M) vs PAL
     bool IsNTSCLines() const;
 
+    // Check if frames are woven film frames (progressive) rather than video frames
+    bool IsIvtc() const;
+
+    // Check if each output frame is a single field (double rate)
+    bool IsFieldOutput() const { return fieldOutput; }
+
+    // Number of frames that can be decoded at once; GetFrame may be called
+    // concurrently when above 1
+    int GetMaxDecodeThreads() const { return maxContexts; }
+
+    // For each frame, the frame whose picture it repeats (itself if none),
+    // from runs of identical CAV picture numbers and pad frames
+    std::vector<int> GetRepeatSourceFrames() const;
+
+    // Metadata DBs read for the TBCs and their extra sources
+    std::vector<std::filesystem::path> GetMetadataPaths() const;
+
     // Check if source is widescreen (16:9)
     bool IsWidescreen() const;
 
@@ -117,27 +176,126 @@ public:
     // Set seek pre-roll (for accurate seeking)
     void SetSeekPreRoll(int preroll);
 
-    // Get a frame - writes YUV float data to the provided buffers
-    // yData, uData, vData: pointers to output buffers (float)
+    // Get a frame - writes samples in the output format to the provided buffers
+    // In field output mode, frameNumber is a field number: frame
+    // frameNumber / 2, first field for even numbers and second for odd.
+    // yData, uData, vData: pointers to output planes (Y/Cb/Cr or R/G/B;
+    // uData and vData are null for gray output)
     // yStride, uStride, vStride: strides in bytes
     // If stats is non-null, accumulates dropout correction statistics.
+    // If aux is non-null, its planes are written from the same decode.
+    // If metrics is non-null, it receives luma statistics gathered while
+    // the output is written.
     // Returns true on success
-    bool GetFrame(int frameNumber, float *yData, float *uData, float *vData,
+    bool GetFrame(int frameNumber, uint8_t *yData, uint8_t *uData, uint8_t *vData,
                   int yStride, int uStride, int vStride,
-                  DropoutCorrectionStats *stats = nullptr);
+                  DropoutCorrectionStats *stats = nullptr,
+                  const VSAnalogAuxPlanes *aux = nullptr,
+                  FrameMetrics *metrics = nullptr);
 
 private:
     std::unique_ptr<TbcReader> reader;        // Primary (luma/composite) source
-    std::unique_ptr<TbcReader> chromaReader;  // Optional separate chroma source
+    std::unique_ptr<TbcReader> chromaReader;  // Optional separate chroma (or Pb) source
+    std::unique_ptr<TbcReader> prReader;      // Pr source (component video only)
     VSAnalogVideoProperties properties;
     int seekPreRoll = 0;
-    std::mutex decodeMutex;  // Protect decoding (single-threaded access to ld-decode)
+    int paddingMultiple = 8;
+    bool reverseFields = false;
+    bool fieldOutput = false;
+    bool dropoutCorrect = false;
+    VSAnalogOutputFormat outputFormat = VSAnalogOutputFormat::YUV444PS;
+    bool matrixBT709 = false;
+    float outputMatrix[3][3] = {};  // Y′CbCr to output (fused conversions only)
+
+    // Most recent frame decode of a context: serves both fields of a frame
+    // in field output mode, and its buffers are reused by the next decode
+    struct DecodedFrame;
+
+    // Readers (with their ld-decode decoders, which keep state between
+    // calls) and decode buffers used by one frame decode at a time. The
+    // first context uses the source's own readers; more are created on
+    // demand up to maxContexts, sharing the readers' metadata.
+    struct DecodeContext;
+    std::mutex contextMutex;
+    std::condition_variable contextReleased;
+    std::vector<std::unique_ptr<DecodeContext>> idleContexts;
+    int numContexts = 0;
+    int maxContexts = 1;
+
+    // Take an idle context (preferring one holding videoFrame's decode),
+    // creating one if all are busy and fewer than maxContexts exist, else
+    // waiting for one. Throws VSAnalogException if creating one fails.
+    std::unique_ptr<DecodeContext> acquireContext(int videoFrame);
+    void releaseContext(std::unique_ptr<DecodeContext> context);
+    std::unique_ptr<DecodeContext> createContext();
+
+    // Measure the frame rate of decoding with 1, 2, 4... up to maxContexts
+    // contexts on frames from the middle of the source, and return the
+    // fewest threads within a few percent of the best (0 if the source is
+    // too short or a decode fails). Keeps only that many contexts.
+    int calibrateDecodeThreads();
+
+    // Luma block averages of recently output frames, for
+    // FrameMetrics::lumaDiff (keyed by output frame number), gathered from
+    // the output rows, and the output frames with metrics under way
+    std::mutex blockMeansMutex;
+    std::condition_variable blockMeansAdded;
+    std::deque<std::pair<int, std::shared_ptr<const std::vector<float>>>> recentBlockMeans;
+    std::multiset<int> measuringFrames;
+    // Active rows of an output frame (of one field for fieldParity >= 0)
+    int outputActiveHeight(int fieldParity) const;
+    void addBlockMeans(int frameNumber, std::shared_ptr<const std::vector<float>> means);
+    // Luma block averages of output frame frameNumber: those of its output,
+    // waiting for them if it's being output on another context, or else
+    // measured by decoding it on context. Null if it can't be decoded.
+    std::shared_ptr<const std::vector<float>> lumaBlockMeans(DecodeContext &context, int frameNumber);
+    void finishMetrics(DecodeContext &context, int frameNumber,
+                       FrameMetricsAccumulator &accumulator, FrameMetrics &metrics);
 
     void initProperties();
-    void convertToFloat(const ComponentFrame &lumaFrame,
-                        const ComponentFrame *chromaFrame,
-                        float *yData, float *uData, float *vData,
-                        int yStride, int uStride, int vStride);
+    void initOutputMatrix();
+
+    // Whether rows must be staged in float and written by storeRow, rather
+    // than converted straight into YUV444PS/GRAYS planes
+    bool needsStaging(bool gray) const {
+        return outputFormat == VSAnalogOutputFormat::YUV444PH ||
+               (!gray && (outputFormat != VSAnalogOutputFormat::YUV444PS || matrixBT709));
+    }
+
+    // Component video: read and dropout-correct the Y, Pb and Pr fields of
+    // a frame in parallel, then convert their samples straight to output
+    bool getComponentFrame(DecodeContext &context, int frameNumber,
+                           uint8_t *yData, uint8_t *uData, uint8_t *vData,
+                           int yStride, int uStride, int vStride,
+                           DropoutCorrectionStats *stats, const VSAnalogAuxPlanes *aux,
+                           FrameMetrics *metrics);
+    void convertComponent(const SourceField (&fields)[3][2],
+                          uint8_t *yData, uint8_t *uData, uint8_t *vData,
+                          int yStride, int uStride, int vStride,
+                          int fieldParity, FrameMetricsAccumulator *metrics);
+
+    // Write one row of staged Y′CbCr (or gray) samples in the output format.
+    // scratch holds 3 * count floats (used for matrixed half output).
+    void storeRow(const float *rowY, const float *rowCb, const float *rowCr,
+                  bool gray, uint8_t *yRow, uint8_t *uRow, uint8_t *vRow,
+                  int count, float *scratch) const;
+    // Write auxiliary planes from a frame's [first, second] field pair of
+    // each TBC. The mask combines the dropouts of all pairs, marking those
+    // listed in frameStats.unresolved as uncorrected; raw samples come from
+    // the first pair. fieldParity is as for convertOutput.
+    void writeAuxPlanes(const SourceField (*fieldPairs)[2], int numPairs,
+                        const DropoutCorrectionStats &frameStats,
+                        const VSAnalogAuxPlanes &aux, int fieldParity) const;
+    // Convert the active area of a decoded frame to the output format.
+    // fieldParity selects the frame lines of one field (0 = first field's
+    // even lines, 1 = second field's odd lines); -1 converts the whole
+    // interleaved frame. If metrics is non-null, every active luma row is
+    // added to it.
+    void convertOutput(const ComponentFrame &lumaFrame,
+                       const ComponentFrame *chromaFrame,
+                       uint8_t *yData, uint8_t *uData, uint8_t *vData,
+                       int yStride, int uStride, int vStride,
+                       int fieldParity = -1, FrameMetricsAccumulator *metrics = nullptr);
 };
 
 #endif // ANALOG4FSC_H
@@ -0,0 +1,53 @@
+/******************************************************************************
+ * autotune.cpp
+ * vapoursynth-analog - Per-host tuning results kept between sessions
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "autotune.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <QDir>
+#include <QSettings>
+#include <QStandardPaths>
+
+namespace {
+
+// QSettings objects on one file aren't coordinated within a process
+std::mutex settingsMutex;
+
+QString settingsDir() {
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    return cacheDir.isEmpty() ? QString() : cacheDir + "/vsanalog";
+}
+
+// '/' separates QSettings groups, so setup keys use '-' between parts
+QString settingsKey(const std::string &setupKey) {
+    return QString::fromStdString("decode_threads/" + setupKey + "-cpu" +
+                                  std::to_string(std::thread::hardware_concurrency()));
+}
+
+} // anonymous namespace
+
+int VSAnalogAutotune::decodeThreads(const std::string &setupKey) {
+    const QString dir = settingsDir();
+    if (dir.isEmpty()) return 0;
+
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    QSettings settings(dir + "/autotune.ini", QSettings::IniFormat);
+    return settings.value(settingsKey(setupKey), 0).toInt();
+}
+
+void VSAnalogAutotune::storeDecodeThreads(const std::string &setupKey, int threads) {
+    const QString dir = settingsDir();
+    if (dir.isEmpty() || !QDir().mkpath(dir)) return;
+
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    QSettings settings(dir + "/autotune.ini", QSettings::IniFormat);
+    settings.setValue(settingsKey(setupKey), threads);
+    settings.sync();
+}
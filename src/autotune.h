@@ -0,0 +1,28 @@
+/******************************************************************************
+ * autotune.h
+ * vapoursynth-analog - Per-host tuning results kept between sessions
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <string>
+
+// Settings measured best on this host, kept in the user's cache directory
+// (<generic cache>/vsanalog/autotune.ini) so that calibration runs once per
+// host and decode setup. Entries are keyed by the caller's description of the
+// setup plus the host's hardware thread count, so moving the cache to a
+// different machine (or resizing a VM) calibrates again.
+class VSAnalogAutotune {
+public:
+    // Decode threads calibrated for this setup, or 0 if not calibrated yet
+    static int decodeThreads(const std::string &setupKey);
+
+    // Remember the decode threads calibrated for this setup. Failing to
+    // save only means the next open calibrates again.
+    static void storeDecodeThreads(const std::string &setupKey, int threads);
+};
+
+#endif // AUTOTUNE_H
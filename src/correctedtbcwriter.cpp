@@ -0,0 +1,186 @@
+/******************************************************************************
+ * correctedtbcwriter.cpp
+ * vapoursynth-analog - Write dropout-corrected TBC files
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "correctedtbcwriter.h"
+#include "analog4fsc.h"
+#include "pipefieldsource.h"
+#include "sqlite3_metadata_writer.h"
+#include "tbcreader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <QDebug>
+
+namespace {
+
+// Results gathered by one worker, merged once all workers finish
+struct WorkerResult {
+    int framesRewritten = 0;
+    DropoutCorrectionStats stats;
+    QVector<qint32> seqNos;
+    QVector<DropoutSpan> unresolved;
+    std::string error;
+};
+
+bool writeField(std::fstream &out, const SourceField &field) {
+    // Fields are stored back to back as 16-bit samples, in sequence order
+    const auto fieldBytes = static_cast<std::streamoff>(field.data.size() * sizeof(quint16));
+    out.seekp(static_cast<std::streamoff>(field.field.seqNo - 1) * fieldBytes);
+    out.write(reinterpret_cast<const char *>(field.data.data()), fieldBytes);
+    return static_cast<bool>(out);
+}
+
+void correctFrames(TbcReader &reader, const std::filesystem::path &outputPath,
+                   std::atomic<int> &nextFrame, int numFrames, WorkerResult &result) {
+    std::fstream out(outputPath, std::ios::in | std::ios::out | std::ios::binary);
+    if (!out) {
+        result.error = "Failed to open output TBC for writing: " + outputPath.string();
+        return;
+    }
+
+    SourceField firstField, secondField;
+    DropoutCorrectionStats frameStats;
+    frameStats.unresolved = &result.unresolved;
+
+    for (int frame = nextFrame++; frame < numFrames; frame = nextFrame++) {
+        // Frames without dropouts are already correct in the copied TBC
+        if (!reader.frameHasDropouts(frame)) continue;
+
+        if (!reader.loadCorrectedFields(frame, firstField, secondField, &frameStats)) {
+            result.error = reader.getLastError().toStdString();
+            return;
+        }
+        if (!writeField(out, firstField) || !writeField(out, secondField)) {
+            result.error = "Failed to write corrected fields for frame " + std::to_string(frame);
+            return;
+        }
+
+        result.seqNos.append(firstField.field.seqNo);
+        result.seqNos.append(secondField.field.seqNo);
+        result.framesRewritten++;
+    }
+
+    result.stats.corrected = frameStats.corrected;
+    result.stats.failed = frameStats.failed;
+    result.stats.totalDistance = frameStats.totalDistance;
+}
+
+} // anonymous namespace
+
+CorrectedTbcSummary writeCorrectedTbc(const std::filesystem::path &sourcePath,
+                                      const std::filesystem::path &outputPath,
+                                      const CorrectedTbcOptions &opts) {
+    if (isPipeInput(sourcePath)) {
+        throw VSAnalogException("The source TBC must be a file, not a pipe");
+    }
+    std::error_code ec;
+    if (std::filesystem::equivalent(sourcePath, outputPath, ec)) {
+        throw VSAnalogException("Output TBC must differ from the source TBC");
+    }
+
+    TbcReader::Configuration config;
+    config.decoder = TbcReader::DecoderType::Mono;  // Fields are never decoded
+    config.paddingMultiple = 0;
+    config.dropoutCorrect = true;
+    config.dropoutOvercorrect = opts.dropoutOvercorrect;
+    config.dropoutIntra = opts.dropoutIntra;
+    config.dropoutDetect = opts.dropoutDetect;
+
+    auto reader = std::make_unique<TbcReader>();
+    if (!reader->open(sourcePath, config)) {
+        throw VSAnalogException("Failed to open TBC file: " +
+                                reader->getLastError().toStdString());
+    }
+    for (const auto &extraPath : opts.extraSources) {
+        if (!reader->addExtraSource(extraPath)) {
+            throw VSAnalogException("Failed to add extra source: " +
+                                    reader->getLastError().toStdString());
+        }
+    }
+
+    // Each worker gets its own decode context: SourceVideo file access and
+    // the correction path are not thread-safe, but the metadata is shared.
+    std::vector<std::unique_ptr<TbcReader>> readers;
+    readers.push_back(std::move(reader));
+
+    const int numFrames = readers[0]->getNumFrames();
+    int numThreads = opts.threads > 0
+        ? opts.threads
+        : static_cast<int>(std::thread::hardware_concurrency());
+    numThreads = std::clamp(numThreads, 1, std::max(1, numFrames));
+    while (static_cast<int>(readers.size()) < numThreads) {
+        std::unique_ptr<TbcReader> context = readers[0]->createDecodeContext();
+        if (!context) {
+            throw VSAnalogException("Failed to open TBC file: " +
+                                    readers[0]->getLastError().toStdString());
+        }
+        readers.push_back(std::move(context));
+    }
+
+    // Start from verbatim copies; workers then overwrite only frames that
+    // had dropouts, in place.
+    std::filesystem::path outputSidecar = outputPath;
+    outputSidecar.replace_extension(".db");
+    const std::filesystem::path sourceSidecar =
+        readers[0]->getMetadataDbPath().toStdString();
+
+    if (!std::filesystem::copy_file(sourcePath, outputPath,
+                                    std::filesystem::copy_options::overwrite_existing, ec)) {
+        throw VSAnalogException("Failed to copy TBC to " + outputPath.string() + ": " + ec.message());
+    }
+    if (!std::filesystem::copy_file(sourceSidecar, outputSidecar,
+                                    std::filesystem::copy_options::overwrite_existing, ec)) {
+        throw VSAnalogException("Failed to copy metadata to " + outputSidecar.string() + ": " + ec.message());
+    }
+
+    qInfo() << "Writing dropout-corrected TBC:" << QString::fromStdString(outputPath.string())
+            << "frames:" << numFrames << "workers:" << numThreads
+            << "extra sources:" << static_cast<int>(opts.extraSources.size());
+
+    std::atomic<int> nextFrame{0};
+    std::vector<WorkerResult> results(numThreads);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < numThreads; i++) {
+        workers.emplace_back(correctFrames, std::ref(*readers[i]), std::cref(outputPath),
+                             std::ref(nextFrame), numFrames, std::ref(results[i]));
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    CorrectedTbcSummary summary;
+    QVector<qint32> seqNos;
+    QVector<DropoutSpan> unresolved;
+    for (const WorkerResult &result : results) {
+        if (!result.error.empty()) {
+            throw VSAnalogException(result.error);
+        }
+        summary.framesRewritten += result.framesRewritten;
+        summary.stats.corrected += result.stats.corrected;
+        summary.stats.failed += result.stats.failed;
+        summary.stats.totalDistance += result.stats.totalDistance;
+        for (qint32 seqNo : result.seqNos) seqNos.append(seqNo);
+        for (const DropoutSpan &span : result.unresolved) unresolved.append(span);
+    }
+
+    if (!Sqlite3MetadataWriter::replaceDropOuts(QString::fromStdString(outputSidecar.string()),
+                                                seqNos, unresolved)) {
+        throw VSAnalogException("Failed to update dropouts in " + outputSidecar.string());
+    }
+
+    qInfo() << "Dropout-corrected TBC written:" << summary.framesRewritten << "frames rewritten,"
+            << summary.stats.corrected << "dropouts corrected,"
+            << summary.stats.failed << "left uncorrected";
+
+    return summary;
+}
@@ -0,0 +1,38 @@
+/******************************************************************************
+ * correctedtbcwriter.h
+ * vapoursynth-analog - Write dropout-corrected TBC files
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef CORRECTEDTBCWRITER_H
+#define CORRECTEDTBCWRITER_H
+
+#include <filesystem>
+#include <vector>
+
+#include "dropoutcorrector.h"
+
+struct CorrectedTbcOptions {
+    bool dropoutOvercorrect = false;  // Extend dropout boundaries (±24 samples)
+    bool dropoutIntra = false;        // Intra-field only correction
+    int dropoutDetect = 0;            // Signal-based dropout detection (0 = off, 1 = auto, 2 = always)
+    std::vector<std::filesystem::path> extraSources;  // Extra TBC sources for multi-source correction
+    int threads = 0;                  // Parallel workers (0 = one per hardware thread)
+};
+
+struct CorrectedTbcSummary {
+    int framesRewritten = 0;          // Frames that had dropouts and were corrected
+    DropoutCorrectionStats stats;     // Totals across all frames
+};
+
+// Stream a TBC through DropoutCorrector (with any extra sources) on parallel
+// workers, writing a corrected copy to outputPath plus a metadata sidecar
+// (<output base>.db) whose dropout table lists only the dropouts that could
+// not be corrected. Later decodes of the output then skip the correction
+// cost. Throws VSAnalogException on failure.
+CorrectedTbcSummary writeCorrectedTbc(const std::filesystem::path &sourcePath,
+                                      const std::filesystem::path &outputPath,
+                                      const CorrectedTbcOptions &opts);
+
+#endif // CORRECTEDTBCWRITER_H
@@ -10,24 +10,84 @@
  ******************************************************************************/
 
 #include "dropoutcorrector.h"
+#include "fieldgeometry.h"
 #include "filters.h"
 
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <vector>
+
 DropoutCorrector::DropoutCorrector(const LdDecodeMetaData::VideoParameters &videoParams)
     : videoParameters(videoParams)
+    , correctDropOutFn(selectForFieldGeometry(videoParams,
+                                              &DropoutCorrector::correctDropOut<NTSC_FIELD_WIDTH>,
+                                              &DropoutCorrector::correctDropOut<PAL_FIELD_WIDTH>,
+                                              &DropoutCorrector::correctDropOut<0>))
 {
 }
 
+DropoutFieldStats *DropoutCorrectionStats::field(qint32 seqNo) {
+    for (DropoutFieldStats &entry : fields) {
+        if (entry.seqNo == seqNo) return &entry;
+    }
+    for (DropoutFieldStats &entry : fields) {
+        if (entry.seqNo == -1) {
+            entry.seqNo = seqNo;
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void DropoutCorrectionStats::add(const DropoutCorrectionStats &other) {
+    corrected += other.corrected;
+    failed += other.failed;
+    totalDistance += other.totalDistance;
+    for (const DropoutFieldStats &entry : other.fields) {
+        if (entry.seqNo == -1) continue;
+        if (DropoutFieldStats *mine = field(entry.seqNo)) {
+            mine->corrected += entry.corrected;
+            mine->failed += entry.failed;
+            mine->totalDistance += entry.totalDistance;
+        }
+    }
+    if (unresolved && other.unresolved && unresolved != other.unresolved) {
+        unresolved->append(*other.unresolved);
+    }
+}
+
+void DropoutCorrectionStats::addField(const DropoutCorrectionStats &other, qint32 seqNo) {
+    for (const DropoutFieldStats &entry : other.fields) {
+        if (entry.seqNo != seqNo) continue;
+        corrected += entry.corrected;
+        failed += entry.failed;
+        totalDistance += entry.totalDistance;
+        if (DropoutFieldStats *mine = field(seqNo)) {
+            mine->corrected += entry.corrected;
+            mine->failed += entry.failed;
+            mine->totalDistance += entry.totalDistance;
+        }
+    }
+    if (unresolved && other.unresolved && unresolved != other.unresolved) {
+        for (const DropoutSpan &span : *other.unresolved) {
+            if (span.seqNo == seqNo) unresolved->append(span);
+        }
+    }
+}
+
 // Single-source convenience: delegates to multi-source with no extras
 void DropoutCorrector::correctFrame(SourceField &firstField, SourceField &secondField,
                                      bool overCorrect, bool intraField,
                                      DropoutCorrectionStats *stats)
 {
-    correctFrame(firstField, secondField, {}, overCorrect, intraField, stats);
+    correctFrame(firstField, secondField, {}, -1.0, overCorrect, intraField, stats);
 }
 
 // Multi-source correction
 void DropoutCorrector::correctFrame(SourceField &primaryFirst, SourceField &primarySecond,
                                      const QVector<ExtraSourceFrame> &extraSources,
+                                     double primaryQuality,
                                      bool overCorrect, bool intraField,
                                      DropoutCorrectionStats *stats)
 {
@@ -52,9 +112,7 @@ void DropoutCorrector::correctFrame(SourceField &primaryFirst, SourceField &prim
     allFirstFieldMeta[0] = broadcastFirst.field;
     allSecondFieldMeta[0] = broadcastSecond.field;
     allVideoParams[0] = videoParameters;
-    // Compute primary quality from VITS bPSNR
-    sourceQuality[0] = (broadcastFirst.field.vitsMetrics.bPSNR
-                       + broadcastSecond.field.vitsMetrics.bPSNR) / 2.0;
+    sourceQuality[0] = primaryQuality;
 
     // Sources 1..N = extras
     for (qint32 i = 0; i < extraSources.size(); i++) {
@@ -96,13 +154,13 @@ void DropoutCorrector::correctFrame(SourceField &primaryFirst, SourceField &prim
     // Correct both fields
     correctField(firstFieldDropouts, secondFieldDropouts,
                  allFirstFieldData, allSecondFieldData,
-                 true, intraField, availableSources, sourceQuality,
-                 allVideoParams, stats);
+                 broadcastFirst.field.seqNo, true, intraField,
+                 availableSources, sourceQuality, allVideoParams, stats);
 
     correctField(secondFieldDropouts, firstFieldDropouts,
                  allSecondFieldData, allFirstFieldData,
-                 false, intraField, availableSources, sourceQuality,
-                 allVideoParams, stats);
+                 broadcastSecond.field.seqNo, false, intraField,
+                 availableSources, sourceQuality, allVideoParams, stats);
 
     // Write corrected primary data back
     broadcastFirst.data = allFirstFieldData[0];
@@ -113,7 +171,7 @@ void DropoutCorrector::correctField(const QVector<QVector<DropOutLocation>> &thi
                                      const QVector<QVector<DropOutLocation>> &otherFieldDropouts,
                                      QVector<SourceVideo::Data> &thisFieldData,
                                      const QVector<SourceVideo::Data> &otherFieldData,
-                                     bool thisFieldIsFirst, bool intraField,
+                                     qint32 thisFieldSeqNo, bool thisFieldIsFirst, bool intraField,
                                      const QVector<qint32> &availableSources,
                                      const QVector<double> &sourceQuality,
                                      const QVector<LdDecodeMetaData::VideoParameters> &allVideoParams,
@@ -141,16 +199,30 @@ void DropoutCorrector::correctField(const QVector<QVector<DropOutLocation>> &thi
         }
 
         if (stats) {
+            DropoutFieldStats *fieldStats = stats->field(thisFieldSeqNo);
             if (replacement.fieldLine == -1) {
                 stats->failed++;
+                if (fieldStats) fieldStats->failed++;
+                // Overcorrection only widens spans that get replaced: what
+                // stays unresolved is the listed part of this span, if any
+                const DropOutLocation &dropOut = thisFieldDropouts[0][dropoutIndex];
+                const qint32 startx = std::max(dropOut.startx, dropOut.listedStartx);
+                const qint32 endx = std::min(dropOut.endx, dropOut.listedEndx);
+                if (stats->unresolved && startx < endx) {
+                    stats->unresolved->append({thisFieldSeqNo, dropOut.fieldLine, startx, endx});
+                }
             } else {
                 stats->corrected++;
                 stats->totalDistance += replacement.distance;
+                if (fieldStats) {
+                    fieldStats->corrected++;
+                    fieldStats->totalDistance += replacement.distance;
+                }
             }
         }
 
-        correctDropOut(thisFieldDropouts[0][dropoutIndex], replacement, chromaReplacement,
-                       thisFieldData, otherFieldData);
+        (this->*correctDropOutFn)(thisFieldDropouts[0][dropoutIndex], replacement,
+                                  chromaReplacement, thisFieldData, otherFieldData);
     }
 }
 
@@ -167,6 +239,8 @@ QVector<DropoutCorrector::DropOutLocation> DropoutCorrector::populateDropoutsVec
         dropOutLocation.endx = field.dropOuts.endx(dropOutIndex);
         dropOutLocation.fieldLine = field.dropOuts.fieldLine(dropOutIndex);
         dropOutLocation.location = Location::unknown;
+        dropOutLocation.listedStartx = dropOutLocation.startx;
+        dropOutLocation.listedEndx = dropOutLocation.endx;
 
         if (dropOutLocation.fieldLine < 1 || dropOutLocation.fieldLine > vp.fieldHeight) {
             continue;
@@ -209,6 +283,8 @@ QVector<DropoutCorrector::DropOutLocation> DropoutCorrector::setDropOutLocations
                     tempDropOut.endx = dropOuts[index].endx;
                     tempDropOut.fieldLine = dropOuts[index].fieldLine;
                     tempDropOut.location = Location::colourBurst;
+                    tempDropOut.listedStartx = dropOuts[index].listedStartx;
+                    tempDropOut.listedEndx = dropOuts[index].listedEndx;
                     dropOuts.append(tempDropOut);
 
                     dropOuts[index].endx = videoParameters.colourBurstEnd;
@@ -346,6 +422,7 @@ void DropoutCorrector::findPotentialReplacementLine(
     }
 }
 
+template <qint32 FieldWidth>
 void DropoutCorrector::correctDropOut(const DropOutLocation &dropOut,
                                        const Replacement &replacement,
                                        const Replacement &chromaReplacement,
@@ -356,12 +433,13 @@ void DropoutCorrector::correctDropOut(const DropOutLocation &dropOut,
         return;
     }
 
+    const qint32 fieldWidth = FieldWidth > 0 ? FieldWidth : videoParameters.fieldWidth;
     const quint16 *sourceLine = (replacement.isSameField
                                  ? thisFieldData[replacement.sourceNumber].data()
                                  : otherFieldData[replacement.sourceNumber].data())
-                                + ((replacement.fieldLine - 1) * videoParameters.fieldWidth);
+                                + ((replacement.fieldLine - 1) * fieldWidth);
     quint16 *targetLine = thisFieldData[0].data()
-                          + ((dropOut.fieldLine - 1) * videoParameters.fieldWidth);
+                          + ((dropOut.fieldLine - 1) * fieldWidth);
 
     if ((chromaReplacement.fieldLine == -1) ||
         ((dropOut.fieldLine == replacement.fieldLine) &&
@@ -371,19 +449,24 @@ void DropoutCorrector::correctDropOut(const DropOutLocation &dropOut,
         }
     } else {
         Filters filters;
-        QVector<quint16> lineBuf(videoParameters.fieldWidth);
+        // Standard widths keep the line on the stack instead of the heap
+        std::conditional_t<(FieldWidth > 0), std::array<quint16, FieldWidth>,
+                           std::vector<quint16>> lineBuf{};
+        if constexpr (FieldWidth == 0) {
+            lineBuf.resize(fieldWidth);
+        }
         auto filterLineBuf = [&] {
             if (videoParameters.system == PAL) {
-                filters.palLumaFirFilter(lineBuf.data(), lineBuf.size());
+                filters.palLumaFirFilter(lineBuf.data(), fieldWidth);
             } else if (videoParameters.system == NTSC) {
-                filters.ntscLumaFirFilter(lineBuf.data(), lineBuf.size());
+                filters.ntscLumaFirFilter(lineBuf.data(), fieldWidth);
             } else {
-                filters.palMLumaFirFilter(lineBuf.data(), lineBuf.size());
+                filters.palMLumaFirFilter(lineBuf.data(), fieldWidth);
             }
         };
 
         // Extract LF from luma replacement
-        for (qint32 pixel = 0; pixel < videoParameters.fieldWidth; pixel++) {
+        for (qint32 pixel = 0; pixel < fieldWidth; pixel++) {
             lineBuf[pixel] = sourceLine[pixel];
         }
         filterLineBuf();
@@ -395,8 +478,8 @@ void DropoutCorrector::correctDropOut(const DropOutLocation &dropOut,
         const quint16 *chromaLine = (chromaReplacement.isSameField
                                      ? thisFieldData[chromaReplacement.sourceNumber].data()
                                      : otherFieldData[chromaReplacement.sourceNumber].data())
-                                    + ((chromaReplacement.fieldLine - 1) * videoParameters.fieldWidth);
-        for (qint32 pixel = 0; pixel < videoParameters.fieldWidth; pixel++) {
+                                    + ((chromaReplacement.fieldLine - 1) * fieldWidth);
+        for (qint32 pixel = 0; pixel < fieldWidth; pixel++) {
             lineBuf[pixel] = chromaLine[pixel];
         }
         filterLineBuf();
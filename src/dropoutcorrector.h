@@ -15,10 +15,38 @@
 #include "sourcevideo.h"
 #include "sourcefield.h"
 
+// A dropout region, identified by the sequence number of its field
+struct DropoutSpan {
+    qint32 seqNo;
+    qint32 fieldLine;
+    qint32 startx;
+    qint32 endx;
+};
+
+// The counts of DropoutCorrectionStats for one field
+struct DropoutFieldStats {
+    qint32 seqNo = -1;      // Field sequence number, or -1 for an unused entry
+    int corrected = 0;
+    int failed = 0;
+    int totalDistance = 0;
+};
+
 struct DropoutCorrectionStats {
     int corrected = 0;      // Dropout regions successfully replaced
     int failed = 0;         // Dropout regions where no replacement was found
     int totalDistance = 0;   // Sum of spatial distances of all replacements
+    QVector<DropoutSpan> *unresolved = nullptr;  // If set, receives regions left uncorrected
+    DropoutFieldStats fields[2];  // The counts split by field, for a frame's two fields
+
+    // Entry for field seqNo, claiming an unused one if it has none yet.
+    // Null if both entries belong to other fields.
+    DropoutFieldStats *field(qint32 seqNo);
+
+    // Add another's counts, field split and unresolved regions to these
+    void add(const DropoutCorrectionStats &other);
+
+    // Add only what another has for field seqNo
+    void addField(const DropoutCorrectionStats &other, qint32 seqNo);
 };
 
 // Per-source frame data for multi-source correction.
@@ -29,7 +57,7 @@ struct ExtraSourceFrame {
     LdDecodeMetaData::Field firstFieldMeta;
     LdDecodeMetaData::Field secondFieldMeta;
     LdDecodeMetaData::VideoParameters videoParams;
-    double quality = -1.0;  // Frame quality (average bPSNR of both fields)
+    double quality = -1.0;  // Frame quality (average SNR of both fields in dB)
 };
 
 class DropoutCorrector {
@@ -45,8 +73,10 @@ public:
     // Multi-source correction.
     // Primary fields are modified in place. Extra sources provide replacement
     // data from additional captures aligned via VBI frame numbers.
+    // primaryQuality ranks the primary against extra sources' quality.
     void correctFrame(SourceField &primaryFirst, SourceField &primarySecond,
                       const QVector<ExtraSourceFrame> &extraSources,
+                      double primaryQuality,
                       bool overCorrect, bool intraField,
                       DropoutCorrectionStats *stats = nullptr);
 
@@ -62,6 +92,9 @@ private:
         qint32 startx;
         qint32 endx;
         Location location;
+        // Span as listed, before overcorrection widened startx..endx
+        qint32 listedStartx;
+        qint32 listedEndx;
     };
 
     struct Replacement {
@@ -80,7 +113,7 @@ private:
                       const QVector<QVector<DropOutLocation>> &otherFieldDropouts,
                       QVector<SourceVideo::Data> &thisFieldData,
                       const QVector<SourceVideo::Data> &otherFieldData,
-                      bool thisFieldIsFirst, bool intraField,
+                      qint32 thisFieldSeqNo, bool thisFieldIsFirst, bool intraField,
                       const QVector<qint32> &availableSources,
                       const QVector<double> &sourceQuality,
                       const QVector<LdDecodeMetaData::VideoParameters> &allVideoParams,
@@ -110,6 +143,13 @@ private:
                                       const QVector<LdDecodeMetaData::VideoParameters> &allVideoParams,
                                       QVector<Replacement> &candidates);
 
+    // correctDropOut instantiated for the field size (see fieldgeometry.h)
+    void (DropoutCorrector::*correctDropOutFn)(const DropOutLocation &, const Replacement &,
+                                               const Replacement &,
+                                               QVector<SourceVideo::Data> &,
+                                               const QVector<SourceVideo::Data> &);
+
+    template <qint32 FieldWidth>
     void correctDropOut(const DropOutLocation &dropOut,
                         const Replacement &replacement,
                         const Replacement &chromaReplacement,
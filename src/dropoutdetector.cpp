@@ -0,0 +1,167 @@
+/******************************************************************************
+ * dropoutdetector.cpp
+ * vapoursynth-analog - Signal-based dropout detection for TBC field data
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "dropoutdetector.h"
+#include "fieldgeometry.h"
+#include "simd.h"
+
+#include <algorithm>
+
+namespace {
+
+// Level limits in IRE. Composite chroma on saturated colours reaches about
+// 131 IRE and -24 IRE; sync tip is at -40 IRE.
+constexpr double HIGH_LIMIT_IRE = 145.0;
+constexpr double LOW_LIMIT_IRE = -30.0;
+
+// Samples scanned per block (one 128-bit vector of 16-bit samples)
+constexpr int BLOCK = 8;
+
+// A flatline is at least this many consecutive identical samples (two
+// blocks); noise in real captures makes even flat picture areas vary
+constexpr int MIN_FLAT_BLOCKS = 2;
+
+// Detected regions closer than this are merged, and each is padded by
+// PAD samples on both sides to cover the ringing around a dropout
+constexpr int MERGE_GAP = 16;
+constexpr int PAD = 4;
+
+// Scan one block: bit i of the result is set if sample i is outside
+// [low, high]; flat is set if all samples equal the one after them
+// (block[0..8] are read). Samples at low or high are inside.
+inline unsigned scanBlockScalar(const quint16 *block, quint16 low, quint16 high, bool &flat) {
+    unsigned mask = 0;
+    flat = true;
+    for (int i = 0; i < BLOCK; i++) {
+        if (block[i] > high || block[i] < low) mask |= 1u << i;
+        flat = flat && block[i] == block[i + 1];
+    }
+    return mask;
+}
+
+inline unsigned scanBlock(const quint16 *block, quint16 low, quint16 high, bool &flat) {
+#if defined(VSANALOG_SSE2)
+    // SSE2 only compares signed 16-bit lanes; bias both sides by 0x8000
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+    const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+    const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 1));
+    const __m128i biased = _mm_xor_si128(samples, bias);
+    const __m128i outside = _mm_or_si128(
+        _mm_cmpgt_epi16(biased, _mm_set1_epi16(static_cast<short>(high ^ 0x8000))),
+        _mm_cmplt_epi16(biased, _mm_set1_epi16(static_cast<short>(low ^ 0x8000))));
+    flat = _mm_movemask_epi8(_mm_cmpeq_epi16(samples, next)) == 0xFFFF;
+    return static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_packs_epi16(outside, _mm_setzero_si128())));
+#elif defined(VSANALOG_NEON)
+    static const uint16_t bitValues[BLOCK] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint16x8_t samples = vld1q_u16(block);
+    const uint16x8_t next = vld1q_u16(block + 1);
+    const uint16x8_t outside = vorrq_u16(vcgtq_u16(samples, vdupq_n_u16(high)),
+                                         vcltq_u16(samples, vdupq_n_u16(low)));
+    flat = vminvq_u16(vceqq_u16(samples, next)) == 0xFFFF;
+    return vaddvq_u16(vandq_u16(outside, vld1q_u16(bitValues)));
+#else
+    return scanBlockScalar(block, low, high, flat);
+#endif
+}
+
+} // anonymous namespace
+
+DropoutDetector::DropoutDetector(const LdDecodeMetaData::VideoParameters &videoParams)
+    : videoParameters(videoParams)
+{
+    const double black = videoParameters.black16bIre;
+    const double ireStep = (videoParameters.white16bIre - black) / 100.0;
+    lowLimit = static_cast<quint16>(std::clamp(black + LOW_LIMIT_IRE * ireStep, 1.0, 65534.0));
+    highLimit = static_cast<quint16>(std::clamp(black + HIGH_LIMIT_IRE * ireStep, 1.0, 65534.0));
+    detectFn = selectForFieldGeometry(videoParameters,
+                                      &DropoutDetector::detectField<NTSC_FIELD_WIDTH>,
+                                      &DropoutDetector::detectField<PAL_FIELD_WIDTH>,
+                                      &DropoutDetector::detectField<0>);
+}
+
+int DropoutDetector::detect(const SourceVideo::Data &fieldData, DropOuts &dropOuts) const {
+    return (this->*detectFn)(fieldData, dropOuts);
+}
+
+template <qint32 FieldWidth>
+int DropoutDetector::detectField(const SourceVideo::Data &fieldData, DropOuts &dropOuts) const {
+    const qint32 fieldWidth = FieldWidth > 0 ? FieldWidth : videoParameters.fieldWidth;
+    const qint32 firstLine = std::max(videoParameters.firstActiveFieldLine, 0);
+    const qint32 lastLine = std::min(videoParameters.lastActiveFieldLine,
+                                     static_cast<qint32>(fieldData.size() / fieldWidth));
+    int added = 0;
+    for (qint32 line = firstLine; line < lastLine; line++) {
+        // Field lines in DropOuts are 1-based
+        detectLine(fieldData.data() + static_cast<ptrdiff_t>(line) * fieldWidth,
+                   line + 1, dropOuts, added);
+    }
+    return added;
+}
+
+void DropoutDetector::detectLine(const quint16 *line, qint32 fieldLine, DropOuts &dropOuts,
+                                 int &added) const {
+    const qint32 start = videoParameters.activeVideoStart;
+    const qint32 end = videoParameters.activeVideoEnd;
+
+    // Current region being grown, as [spanStart, spanEnd)
+    qint32 spanStart = -1;
+    qint32 spanEnd = -1;
+    auto flush = [&]() {
+        if (spanStart < 0) return;
+        dropOuts.append(std::max(start, spanStart - PAD), std::min(end, spanEnd + PAD), fieldLine);
+        added++;
+        spanStart = -1;
+    };
+    auto mark = [&](qint32 from, qint32 to) {
+        if (spanStart >= 0 && from <= spanEnd + MERGE_GAP) {
+            spanEnd = std::max(spanEnd, to);
+            return;
+        }
+        flush();
+        spanStart = from;
+        spanEnd = to;
+    };
+
+    qint32 flatStart = -1;
+    qint32 flatBlocks = 0;
+    qint32 x = start;
+    // Blocks also read the sample after them, so stop one short of the end
+    for (; x + BLOCK < end; x += BLOCK) {
+        bool flat;
+        unsigned outside = scanBlock(line + x, lowLimit, highLimit, flat);
+
+        if (flat) {
+            if (flatBlocks++ == 0) flatStart = x;
+        } else {
+            if (flatBlocks >= MIN_FLAT_BLOCKS) mark(flatStart, x + BLOCK);
+            flatBlocks = 0;
+        }
+
+        while (outside) {
+            // Lowest set bit first, so regions grow left to right
+            int i = 0;
+            while (!(outside & (1u << i))) i++;
+            outside &= outside - 1;
+            mark(x + i, x + i + 1);
+        }
+    }
+    if (flatBlocks >= MIN_FLAT_BLOCKS) mark(flatStart, x);
+
+    for (; x < end; x++) {
+        if (line[x] > highLimit || line[x] < lowLimit) mark(x, x + 1);
+    }
+    flush();
+}
+
+bool DropoutDetector::metadataListsDropouts(LdDecodeMetaData &metadata) {
+    const qint32 numFields = metadata.getNumberOfFields();
+    for (qint32 fieldNo = 1; fieldNo <= numFields; fieldNo++) {
+        if (!metadata.getField(fieldNo).dropOuts.empty()) return true;
+    }
+    return false;
+}
@@ -0,0 +1,47 @@
+/******************************************************************************
+ * dropoutdetector.h
+ * vapoursynth-analog - Signal-based dropout detection for TBC field data
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef DROPOUTDETECTOR_H
+#define DROPOUTDETECTOR_H
+
+#include "lddecodemetadata.h"
+#include "sourcevideo.h"
+
+// Finds dropouts in the active area of raw 16-bit field samples, for sources
+// whose metadata doesn't list any (e.g. sidecars from other tools). Flags:
+//   - levels far outside the video range: above peak white plus chroma, or
+//     intruding towards sync tip
+//   - flatlines: runs of identical samples, left where the RF carrier was
+//     lost and the demodulator held or clipped its output
+// Detected regions are added to the field's DropOuts so that DropoutCorrector
+// handles them like metadata-listed ones.
+class DropoutDetector {
+public:
+    explicit DropoutDetector(const LdDecodeMetaData::VideoParameters &videoParams);
+
+    // Append the dropouts found in fieldData to dropOuts. Returns the number
+    // of regions added.
+    int detect(const SourceVideo::Data &fieldData, DropOuts &dropOuts) const;
+
+    // Whether any field of the metadata lists a dropout
+    static bool metadataListsDropouts(LdDecodeMetaData &metadata);
+
+private:
+    LdDecodeMetaData::VideoParameters videoParameters;
+    quint16 lowLimit;   // Samples below this are sync intrusions
+    quint16 highLimit;  // Samples above this are beyond white plus chroma
+
+    // detectField instantiated for the field size (see fieldgeometry.h)
+    int (DropoutDetector::*detectFn)(const SourceVideo::Data &, DropOuts &) const;
+
+    template <qint32 FieldWidth>
+    int detectField(const SourceVideo::Data &fieldData, DropOuts &dropOuts) const;
+    void detectLine(const quint16 *line, qint32 fieldLine, DropOuts &dropOuts,
+                    int &added) const;
+};
+
+#endif // DROPOUTDETECTOR_H
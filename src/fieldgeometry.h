@@ -0,0 +1,36 @@
+/******************************************************************************
+ * fieldgeometry.h
+ * vapoursynth-analog - Field sizes of standard TBC output
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef FIELDGEOMETRY_H
+#define FIELDGEOMETRY_H
+
+#include "lddecodemetadata.h"
+
+// ld-decode and vhs-decode write fields of one size per system. Line loops
+// over raw fields are instantiated with these widths as template arguments,
+// so line strides and full-line trip counts become constants the compiler
+// can unroll and vectorize. Any other size uses the instantiation for width
+// 0, which reads the width from the video parameters.
+constexpr qint32 NTSC_FIELD_WIDTH = 910;
+constexpr qint32 NTSC_FIELD_HEIGHT = 263;
+constexpr qint32 PAL_FIELD_WIDTH = 1135;
+constexpr qint32 PAL_FIELD_HEIGHT = 313;
+
+// Pick the instantiation matching the video parameters' field size
+template <typename Fn>
+Fn selectForFieldGeometry(const LdDecodeMetaData::VideoParameters &videoParams,
+                          Fn ntsc, Fn pal, Fn generic) {
+    if (videoParams.fieldWidth == NTSC_FIELD_WIDTH && videoParams.fieldHeight == NTSC_FIELD_HEIGHT) {
+        return ntsc;
+    }
+    if (videoParams.fieldWidth == PAL_FIELD_WIDTH && videoParams.fieldHeight == PAL_FIELD_HEIGHT) {
+        return pal;
+    }
+    return generic;
+}
+
+#endif // FIELDGEOMETRY_H
@@ -0,0 +1,164 @@
+/******************************************************************************
+ * fieldquality.cpp
+ * vapoursynth-analog - Noise-based quality estimates of TBC fields
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "fieldquality.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Samples left out next to the burst and the start of active video, where
+// the burst envelope and the picture's rise still ring
+constexpr qint32 PORCH_MARGIN = 4;
+
+// Fewest back porch samples per line worth measuring
+constexpr qint32 MIN_PORCH_SAMPLES = 16;
+
+// Noise floor of 16-bit quantization (1/sqrt(12) LSB), so noiseless
+// synthetic fields rank as very clean rather than infinitely so
+constexpr double QUANTIZATION_NOISE = 0.28867513459481287;
+
+// Deviations are clamped to ±MAX_DEVIATION, as the SSE2 path saturates them
+// to keep each pair of squares within 31 bits. Real back porches sit far
+// inside this range of black.
+constexpr int64_t MAX_DEVIATION = 32767;
+
+// Sum and sum of squares of (sample - offset) over count samples, each
+// clamped to ±MAX_DEVIATION. Also sums the samples after the last full vector.
+inline void sumDeviationsScalar(const quint16 *samples, qint32 count, quint16 offset,
+                                int64_t &sum, int64_t &sumSquares) {
+    sum = 0;
+    sumSquares = 0;
+    for (qint32 i = 0; i < count; i++) {
+        const int64_t deviation = std::clamp<int64_t>(
+            static_cast<int64_t>(samples[i]) - offset, -MAX_DEVIATION, MAX_DEVIATION);
+        sum += deviation;
+        sumSquares += deviation * deviation;
+    }
+}
+
+inline void sumDeviations(const quint16 *samples, qint32 count, quint16 offset,
+                          int64_t &sum, int64_t &sumSquares) {
+    qint32 i = 0;
+    sum = 0;
+    sumSquares = 0;
+#if defined(VSANALOG_SSE2)
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+    const __m128i biasedOffset = _mm_set1_epi16(static_cast<short>(offset ^ 0x8000));
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i limit = _mm_set1_epi16(static_cast<short>(-MAX_DEVIATION));
+    __m128i sums = _mm_setzero_si128();
+    __m128i squares = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+        const __m128i deviations = _mm_max_epi16(
+            _mm_subs_epi16(_mm_xor_si128(block, bias), biasedOffset), limit);
+        sums = _mm_add_epi32(sums, _mm_madd_epi16(deviations, ones));
+        const __m128i pairSquares = _mm_madd_epi16(deviations, deviations);
+        squares = _mm_add_epi64(squares, _mm_unpacklo_epi32(pairSquares, _mm_setzero_si128()));
+        squares = _mm_add_epi64(squares, _mm_unpackhi_epi32(pairSquares, _mm_setzero_si128()));
+    }
+    alignas(16) int32_t sumLanes[4];
+    alignas(16) int64_t squareLanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(sumLanes), sums);
+    _mm_store_si128(reinterpret_cast<__m128i *>(squareLanes), squares);
+    sum = static_cast<int64_t>(sumLanes[0]) + sumLanes[1] + sumLanes[2] + sumLanes[3];
+    sumSquares = squareLanes[0] + squareLanes[1];
+#elif defined(VSANALOG_NEON)
+    const uint16x4_t offsets = vdup_n_u16(offset);
+    const int32x4_t low = vdupq_n_s32(static_cast<int32_t>(-MAX_DEVIATION));
+    const int32x4_t high = vdupq_n_s32(static_cast<int32_t>(MAX_DEVIATION));
+    int32x4_t sums = vdupq_n_s32(0);
+    int64x2_t squares = vdupq_n_s64(0);
+    for (; i + 4 <= count; i += 4) {
+        // The modular difference read as signed is the deviation
+        const int32x4_t deviations = vmaxq_s32(vminq_s32(
+            vreinterpretq_s32_u32(vsubl_u16(vld1_u16(samples + i), offsets)), high), low);
+        sums = vaddq_s32(sums, deviations);
+        squares = vmlal_s32(squares, vget_low_s32(deviations), vget_low_s32(deviations));
+        squares = vmlal_s32(squares, vget_high_s32(deviations), vget_high_s32(deviations));
+    }
+    sum = vaddvq_s32(sums);
+    sumSquares = vaddvq_s64(squares);
+#endif
+    int64_t tailSum, tailSquares;
+    sumDeviationsScalar(samples + i, count - i, offset, tailSum, tailSquares);
+    sum += tailSum;
+    sumSquares += tailSquares;
+}
+
+} // anonymous namespace
+
+FieldQualityEstimator::FieldQualityEstimator(const LdDecodeMetaData::VideoParameters &videoParams)
+    : videoParameters(videoParams)
+    , porchStart(videoParams.colourBurstEnd + PORCH_MARGIN)
+    , porchEnd(videoParams.activeVideoStart - PORCH_MARGIN)
+{
+}
+
+double FieldQualityEstimator::estimate(const SourceVideo::Data &fieldData) const {
+    const qint32 fieldWidth = videoParameters.fieldWidth;
+    const double range = videoParameters.white16bIre - videoParameters.black16bIre;
+    if (videoParameters.colourBurstEnd < 0 || porchEnd - porchStart < MIN_PORCH_SAMPLES ||
+        porchEnd > fieldWidth || range <= 0.0) {
+        return -1.0;
+    }
+
+    const qint32 firstLine = std::max(videoParameters.firstActiveFieldLine, 0);
+    const qint32 lastLine = std::min(videoParameters.lastActiveFieldLine,
+                                     static_cast<qint32>(fieldData.size() / fieldWidth));
+    if (lastLine <= firstLine) return -1.0;
+
+    // Deviations from black stay small on the porch, whatever the line's level
+    const quint16 offset = static_cast<quint16>(
+        std::clamp(videoParameters.black16bIre, 0, 65535));
+    const qint32 count = porchEnd - porchStart;
+    std::vector<double> variances;
+    variances.reserve(lastLine - firstLine);
+    for (qint32 line = firstLine; line < lastLine; line++) {
+        int64_t sum, sumSquares;
+        sumDeviations(fieldData.data() + static_cast<ptrdiff_t>(line) * fieldWidth + porchStart,
+                      count, offset, sum, sumSquares);
+        const double mean = static_cast<double>(sum) / count;
+        variances.push_back(std::max(0.0, static_cast<double>(sumSquares) / count - mean * mean));
+    }
+
+    auto median = variances.begin() + variances.size() / 2;
+    std::nth_element(variances.begin(), median, variances.end());
+    const double noise = std::max(std::sqrt(*median), QUANTIZATION_NOISE);
+    return 20.0 * std::log10(range / noise);
+}
+
+FieldQualityCache::FieldQualityCache(const LdDecodeMetaData::VideoParameters &videoParams,
+                                     qint32 numberOfFields)
+    : estimator(videoParams)
+    , numberOfFields(numberOfFields)
+    , snr(std::make_unique<std::atomic<float>[]>(std::max(numberOfFields, 0)))
+{
+    for (qint32 i = 0; i < numberOfFields; i++) {
+        snr[i].store(std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+    }
+}
+
+double FieldQualityCache::quality(qint32 seqNo, const SourceVideo::Data &fieldData) {
+    if (seqNo < 1 || seqNo > numberOfFields) {
+        return estimator.estimate(fieldData);
+    }
+
+    // Contexts racing on one field compute the same value; either store wins
+    std::atomic<float> &cached = snr[seqNo - 1];
+    float value = cached.load(std::memory_order_relaxed);
+    if (std::isnan(value)) {
+        value = static_cast<float>(estimator.estimate(fieldData));
+        cached.store(value, std::memory_order_relaxed);
+    }
+    return value;
+}
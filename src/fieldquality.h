@@ -0,0 +1,57 @@
+/******************************************************************************
+ * fieldquality.h
+ * vapoursynth-analog - Noise-based quality estimates of TBC fields
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef FIELDQUALITY_H
+#define FIELDQUALITY_H
+
+#include <atomic>
+#include <memory>
+
+#include "lddecodemetadata.h"
+#include "sourcevideo.h"
+
+// Estimates a raw field's signal-to-noise ratio from its back porch, the
+// blanking-level stretch between colour burst and active video, which carries
+// no picture on any active line. Each line's noise is its variance about its
+// own mean (so black-level drift doesn't count), and the median over lines
+// keeps dropouts and head-switching lines from dominating.
+//
+// The result is in dB of the black-to-white range over the RMS noise, on the
+// same scale as ld-decode's black-level PSNR (bPSNR), for ranking captures in
+// multi-source dropout correction.
+class FieldQualityEstimator {
+public:
+    explicit FieldQualityEstimator(const LdDecodeMetaData::VideoParameters &videoParams);
+
+    // SNR of the field in dB, or -1 if the video parameters give no usable
+    // back porch
+    double estimate(const SourceVideo::Data &fieldData) const;
+
+private:
+    LdDecodeMetaData::VideoParameters videoParameters;
+    qint32 porchStart;  // Back porch samples measured, as [porchStart, porchEnd)
+    qint32 porchEnd;
+};
+
+// Field SNRs of one source, measured the first time each field is ranked and
+// shared by all of the source's decode contexts
+class FieldQualityCache {
+public:
+    FieldQualityCache(const LdDecodeMetaData::VideoParameters &videoParams,
+                      qint32 numberOfFields);
+
+    // SNR of field seqNo (1-based) in dB, estimated from fieldData unless
+    // already known
+    double quality(qint32 seqNo, const SourceVideo::Data &fieldData);
+
+private:
+    FieldQualityEstimator estimator;
+    qint32 numberOfFields;
+    std::unique_ptr<std::atomic<float>[]> snr;  // NaN until measured
+};
+
+#endif // FIELDQUALITY_H
@@ -0,0 +1,137 @@
+/******************************************************************************
+ * framemetrics.cpp
+ * vapoursynth-analog - Luma statistics and comb metrics gathered during output
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "framemetrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// VFM's default cthresh (9 of 255) in normalized luma
+constexpr float COMB_THRESHOLD = 9.0f / 255.0f;
+
+} // anonymous namespace
+
+FrameMetricsAccumulator::FrameMetricsAccumulator(int width, int height, bool comb)
+    : width(width)
+    , height(height)
+    , comb(comb)
+    , minimum(1.0f)
+    , maximum(0.0f)
+    , blocks(width, height)
+{
+    if (comb) {
+        above.resize(width);
+        middle.resize(width);
+        combCounts.assign((width + COMB_BLOCK - 1) / COMB_BLOCK, 0);
+    }
+}
+
+void FrameMetricsAccumulator::addRow(const float *row) {
+    const int y = rowsAdded++;
+
+    float rowMin = row[0];
+    float rowMax = row[0];
+    double rowSum = 0.0;
+    for (int x = 0; x < width; x++) {
+        const float v = row[x];
+        rowMin = std::min(rowMin, v);
+        rowMax = std::max(rowMax, v);
+        rowSum += v;
+        const int bin = static_cast<int>(v * FrameMetrics::HISTOGRAM_BINS);
+        histogram[std::clamp(bin, 0, FrameMetrics::HISTOGRAM_BINS - 1)]++;
+    }
+    minimum = std::min(minimum, rowMin);
+    maximum = std::max(maximum, rowMax);
+    sum += rowSum;
+    blocks.addRow(row);
+
+    if (!comb) return;
+
+    // The middle row (y - 1) has both of its neighbours now
+    if (y >= 2) {
+        for (int x = 0; x < width; x++) {
+            const float d1 = middle[x] - above[x];
+            const float d2 = middle[x] - row[x];
+            const bool combedSample = (d1 > COMB_THRESHOLD && d2 > COMB_THRESHOLD) ||
+                                      (d1 < -COMB_THRESHOLD && d2 < -COMB_THRESHOLD);
+            combCounts[x / COMB_BLOCK] += combedSample ? 1 : 0;
+        }
+        combCompared += width;
+        if (y % COMB_BLOCK == 0 || y + 1 == height) {
+            // Row y - 1 closed a block row
+            flushCombBlocks();
+        }
+    }
+    std::swap(above, middle);
+    std::copy(row, row + width, middle.begin());
+}
+
+void FrameMetricsAccumulator::flushCombBlocks() {
+    for (int &count : combCounts) {
+        combMax = std::max(combMax, count);
+        combed += count;
+        count = 0;
+    }
+}
+
+void FrameMetricsAccumulator::finish(FrameMetrics &metrics, std::vector<float> &blockMeans) {
+    blockMeans = blocks.finish();
+
+    const int64_t samples = static_cast<int64_t>(width) * rowsAdded;
+    metrics.lumaAverage = samples > 0 ? sum / static_cast<double>(samples) : 0.0;
+    metrics.lumaMin = samples > 0 ? minimum : 0.0;
+    metrics.lumaMax = samples > 0 ? maximum : 0.0;
+    std::copy(std::begin(histogram), std::end(histogram), std::begin(metrics.histogram));
+
+    metrics.hasComb = comb;
+    if (comb) {
+        flushCombBlocks();
+        metrics.combMax = combMax;
+        metrics.combFraction = combCompared > 0
+            ? static_cast<double>(combed) / static_cast<double>(combCompared) : 0.0;
+    }
+}
+
+LumaBlockMeans::LumaBlockMeans(int width, int height)
+    : width(width)
+    , height(height)
+    , blockSums((width + BLOCK - 1) / BLOCK, 0.0f)
+{
+    blockMeans.reserve(blockSums.size() * ((height + BLOCK - 1) / BLOCK));
+}
+
+void LumaBlockMeans::addRow(const float *row) {
+    const int y = rowsAdded++;
+    for (int x = 0; x < width; x++) {
+        blockSums[x / BLOCK] += row[x];
+    }
+
+    // Close a row of blocks (edge blocks are averaged over what they hold)
+    if ((y + 1) % BLOCK == 0 || y + 1 == height) {
+        const int blockRows = y % BLOCK + 1;
+        for (size_t bx = 0; bx < blockSums.size(); bx++) {
+            const int blockCols = std::min(BLOCK, width - static_cast<int>(bx) * BLOCK);
+            blockMeans.push_back(blockSums[bx] / static_cast<float>(blockRows * blockCols));
+            blockSums[bx] = 0.0f;
+        }
+    }
+}
+
+std::vector<float> LumaBlockMeans::finish() {
+    return std::move(blockMeans);
+}
+
+double LumaBlockMeans::difference(const std::vector<float> &a, const std::vector<float> &b) {
+    if (a.size() != b.size() || a.empty()) return -1.0;
+    double diff = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        diff += std::fabs(a[i] - b[i]);
+    }
+    return diff / static_cast<double>(a.size());
+}
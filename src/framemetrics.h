@@ -0,0 +1,104 @@
+/******************************************************************************
+ * framemetrics.h
+ * vapoursynth-analog - Luma statistics and comb metrics gathered during output
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef FRAMEMETRICS_H
+#define FRAMEMETRICS_H
+
+#include <cstdint>
+#include <vector>
+
+// Statistics of one output frame's luma (Y′ in [0, 1], before any R′G′B′
+// conversion) over its active area, for scene detection, fades and field
+// matching without another pass over the pixels
+struct FrameMetrics {
+    static constexpr int HISTOGRAM_BINS = 16;
+
+    double lumaAverage = 0.0;
+    double lumaMin = 0.0;
+    double lumaMax = 0.0;
+    int64_t histogram[HISTOGRAM_BINS] = {};  // Samples per 1/16 of [0, 1], clamped
+
+    // Mean absolute difference of 8x8 block averages (LumaBlockMeans)
+    // against the previous frame (the previous field of the same parity for
+    // field output), or negative when there is none
+    double lumaDiff = -1.0;
+
+    // Combing between the two fields of a frame (not for field output), as
+    // counted by VFM: a sample is combed when it differs from the lines
+    // above and below in the same direction by more than a threshold
+    bool hasComb = false;
+    int combMax = 0;            // Most combed samples in any 16x16 block
+    double combFraction = 0.0;  // Combed share of all compared samples
+};
+
+// 8x8 block averages of a frame's normalized luma, added row by row, by
+// which frames are compared for FrameMetrics::lumaDiff
+class LumaBlockMeans {
+public:
+    LumaBlockMeans(int width, int height);
+
+    // Add the next row of normalized luma
+    void addRow(const float *row);
+
+    // Averages of every block, a row of blocks at a time (edge blocks are
+    // averaged over what they hold)
+    std::vector<float> finish();
+
+    // Mean absolute difference of two frames' block averages, or -1 if they
+    // don't have the same blocks
+    static double difference(const std::vector<float> &a, const std::vector<float> &b);
+
+private:
+    static constexpr int BLOCK = 8;
+
+    int width;
+    int height;
+    int rowsAdded = 0;
+    std::vector<float> blockSums;   // Current block row's sums
+    std::vector<float> blockMeans;
+};
+
+// Accumulates FrameMetrics from luma rows as the output pass writes them
+class FrameMetricsAccumulator {
+public:
+    // Start a frame of width x height active samples. comb enables comb
+    // metrics, for rows of an interleaved frame.
+    FrameMetricsAccumulator(int width, int height, bool comb);
+
+    // Add the next row of normalized luma
+    void addRow(const float *row);
+
+    // Finish the frame: all of metrics but lumaDiff, which the caller sets
+    // by comparing blockMeans with the previous frame's
+    void finish(FrameMetrics &metrics, std::vector<float> &blockMeans);
+
+private:
+    static constexpr int COMB_BLOCK = 16;
+
+    int width;
+    int height;
+    bool comb;
+    int rowsAdded = 0;
+
+    double sum = 0.0;
+    float minimum;
+    float maximum;
+    int64_t histogram[FrameMetrics::HISTOGRAM_BINS] = {};
+    LumaBlockMeans blocks;
+
+    // The two rows before the newest, for comb detection of the middle row
+    std::vector<float> above;
+    std::vector<float> middle;
+    std::vector<int> combCounts;    // Current comb block row's counts
+    int combMax = 0;
+    int64_t combed = 0;
+    int64_t combCompared = 0;
+
+    void flushCombBlocks();
+};
+
+#endif // FRAMEMETRICS_H
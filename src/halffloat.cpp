@@ -0,0 +1,146 @@
+/******************************************************************************
+ * halffloat.cpp
+ * vapoursynth-analog - Float to IEEE 754 half-precision conversion
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "halffloat.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VSANALOG_HALF_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define VSANALOG_HALF_NEON 1
+#include <arm_neon.h>
+#endif
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t absBits = bits & 0x7FFFFFFF;
+
+    if (absBits >= 0x7F800000) {
+        // Infinity, or NaN with its payload's top bits kept (and quieted)
+        if (absBits == 0x7F800000) return sign | 0x7C00;
+        return static_cast<uint16_t>(sign | 0x7E00 | ((absBits >> 13) & 0x3FF));
+    }
+    if (absBits >= 0x477FF000) {
+        // 65520 and up round beyond the largest half (65504)
+        return sign | 0x7C00;
+    }
+    if (absBits < 0x38800000) {
+        // Below the smallest normal half (2^-14): subnormal or zero.
+        // Anything up to 2^-25 rounds (ties to even) to zero.
+        if (absBits <= 0x33000000) return sign;
+        const uint32_t exponent = absBits >> 23;
+        const uint32_t mantissa = (absBits & 0x7FFFFF) | 0x800000;
+        const uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Normal: rebias the exponent (127 to 15) and round the mantissa from 23
+    // to 10 bits. A carry out of the mantissa correctly bumps the exponent.
+    uint32_t half = (absBits - 0x38000000) >> 13;
+    const uint32_t remainder = absBits & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+namespace {
+
+void floatToHalfRowScalar(const float *src, uint16_t *dst, int count) {
+    for (int x = 0; x < count; x++) {
+        dst[x] = floatToHalf(src[x]);
+    }
+}
+
+#if defined(VSANALOG_HALF_X86)
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx,f16c")))
+#endif
+void floatToHalfRowF16C(const float *src, uint16_t *dst, int count) {
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        const __m256 values = _mm256_loadu_ps(src + x);
+        const __m128i halves = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), halves);
+    }
+    for (; x < count; x++) {
+        dst[x] = floatToHalf(src[x]);
+    }
+}
+
+// F16C instructions are VEX-encoded, so the OS must also have enabled
+// saving AVX state (OSXSAVE plus XCR0 SSE/AVX bits)
+bool cpuHasF16C() {
+    unsigned int ecx;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+#else
+    unsigned int eax, ebx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+#endif
+    const bool osxsave = (ecx >> 27) & 1;
+    const bool avx = (ecx >> 28) & 1;
+    const bool f16c = (ecx >> 29) & 1;
+    if (!osxsave || !avx || !f16c) return false;
+
+#if defined(_MSC_VER)
+    const unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0Low, xcr0High;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    const unsigned long long xcr0 = xcr0Low;
+#endif
+    return (xcr0 & 0x6) == 0x6;
+}
+
+#elif defined(VSANALOG_HALF_NEON)
+
+void floatToHalfRowNeon(const float *src, uint16_t *dst, int count) {
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        const float16x4_t halves = vcvt_f16_f32(vld1q_f32(src + x));
+        vst1_u16(dst + x, vreinterpret_u16_f16(halves));
+    }
+    for (; x < count; x++) {
+        dst[x] = floatToHalf(src[x]);
+    }
+}
+
+#endif
+
+using RowConverter = void (*)(const float *, uint16_t *, int);
+
+RowConverter selectRowConverter() {
+#if defined(VSANALOG_HALF_X86)
+    if (cpuHasF16C()) return floatToHalfRowF16C;
+#elif defined(VSANALOG_HALF_NEON)
+    return floatToHalfRowNeon;
+#endif
+    return floatToHalfRowScalar;
+}
+
+} // anonymous namespace
+
+void floatToHalfRow(const float *src, uint16_t *dst, int count) {
+    static const RowConverter converter = selectRowConverter();
+    converter(src, dst, count);
+}
@@ -0,0 +1,21 @@
+/******************************************************************************
+ * halffloat.h
+ * vapoursynth-analog - Float to IEEE 754 half-precision conversion
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef HALFFLOAT_H
+#define HALFFLOAT_H
+
+#include <cstdint>
+
+// Convert a single float to half precision, rounding to nearest even.
+// Values beyond the half range become infinity; NaNs stay NaN.
+uint16_t floatToHalf(float value);
+
+// Convert a row of floats to half precision. Uses F16C on x86 CPUs that
+// support it and NEON on ARM64, with identical results to floatToHalf.
+void floatToHalfRow(const float *src, uint16_t *dst, int count);
+
+#endif // HALFFLOAT_H
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * motiondetector.cpp
+ * vapoursynth-analog - Block motion between frames of raw TBC fields
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "motiondetector.h"
+#include "fieldgeometry.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Mean change of a block's subcarrier-cycle averages for it to count as
+// moving. Noise a frame apart stays well below this once averaged over a
+// cycle.
+constexpr double MOTION_IRE = 4.0;
+
+constexpr int CYCLE = 4;  // Samples per subcarrier cycle at 4fsc
+
+// SAD of the cycle sums of a block (MotionDetector::BLOCK_WIDTH samples by
+// BLOCK_LINES lines, stride samples apart) against the previous frame's.
+// Each cycle's difference is summed before taking its magnitude, so the
+// subcarrier cancels unless the colour changed.
+inline qint32 blockSadScalar(const quint16 *current, const quint16 *previous, ptrdiff_t stride) {
+    qint32 sad = 0;
+    for (int line = 0; line < MotionDetector::BLOCK_LINES; line++) {
+        for (int x = 0; x < MotionDetector::BLOCK_WIDTH; x += CYCLE) {
+            qint32 diff = 0;
+            for (int i = 0; i < CYCLE; i++) {
+                diff += static_cast<qint32>(current[x + i]) - static_cast<qint32>(previous[x + i]);
+            }
+            sad += std::abs(diff);
+        }
+        current += stride;
+        previous += stride;
+    }
+    return sad;
+}
+
+inline qint32 blockSad(const quint16 *current, const quint16 *previous, ptrdiff_t stride) {
+#if defined(VSANALOG_SSE2)
+    // madd sums adjacent pairs of signed lanes: bias the samples into the
+    // signed range, which cancels in the difference
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i cycleLanes = _mm_set_epi32(0, -1, 0, -1);
+    __m128i sum = _mm_setzero_si128();
+    for (int line = 0; line < MotionDetector::BLOCK_LINES; line++) {
+        for (int x = 0; x < MotionDetector::BLOCK_WIDTH; x += 8) {
+            const __m128i cur = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(current + x)), bias);
+            const __m128i prev = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous + x)), bias);
+            const __m128i pairs = _mm_sub_epi32(_mm_madd_epi16(cur, ones),
+                                                _mm_madd_epi16(prev, ones));
+            // Lanes 0 and 2 hold the two cycles' differences
+            const __m128i cycles = _mm_add_epi32(pairs, _mm_srli_epi64(pairs, 32));
+            const __m128i sign = _mm_srai_epi32(cycles, 31);
+            const __m128i absolute = _mm_sub_epi32(_mm_xor_si128(cycles, sign), sign);
+            sum = _mm_add_epi32(sum, _mm_and_si128(absolute, cycleLanes));
+        }
+        current += stride;
+        previous += stride;
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtsi128_si32(sum);
+#elif defined(VSANALOG_NEON)
+    uint32x4_t sum = vdupq_n_u32(0);
+    for (int line = 0; line < MotionDetector::BLOCK_LINES; line++) {
+        // Four cycle sums of each frame's 16 samples
+        const uint32x4_t cur = vpaddq_u32(vpaddlq_u16(vld1q_u16(current)),
+                                          vpaddlq_u16(vld1q_u16(current + 8)));
+        const uint32x4_t prev = vpaddq_u32(vpaddlq_u16(vld1q_u16(previous)),
+                                           vpaddlq_u16(vld1q_u16(previous + 8)));
+        sum = vaddq_u32(sum, vabdq_u32(cur, prev));
+        current += stride;
+        previous += stride;
+    }
+    return static_cast<qint32>(vaddvq_u32(sum));
+#else
+    return blockSadScalar(current, previous, stride);
+#endif
+}
+
+} // anonymous namespace
+
+MotionDetector::MotionDetector(const LdDecodeMetaData::VideoParameters &videoParams)
+    : videoParameters(videoParams)
+{
+    firstFieldLine = videoParameters.firstActiveFrameLine / 2;
+    blockRows = std::max(0, (videoParameters.lastActiveFrameLine / 2 - firstFieldLine) / BLOCK_LINES);
+    blocksAcross = std::max(0, (videoParameters.activeVideoEnd - videoParameters.activeVideoStart)
+                                   / BLOCK_WIDTH);
+    const double ireScale = (videoParameters.white16bIre - videoParameters.black16bIre) / 100.0;
+    threshold = static_cast<qint32>(MOTION_IRE * ireScale * BLOCK_WIDTH * BLOCK_LINES);
+    detectFn = selectForFieldGeometry(videoParameters,
+                                      &MotionDetector::detectFields<NTSC_FIELD_WIDTH>,
+                                      &MotionDetector::detectFields<PAL_FIELD_WIDTH>,
+                                      &MotionDetector::detectFields<0>);
+}
+
+bool MotionDetector::detect(const SourceVideo::Data *const (&current)[2],
+                            const SourceVideo::Data *const (&previous)[2],
+                            std::vector<int> &movingPerRow) const {
+    return (this->*detectFn)(current, previous, movingPerRow);
+}
+
+template <qint32 FieldWidth>
+bool MotionDetector::detectFields(const SourceVideo::Data *const (&current)[2],
+                                  const SourceVideo::Data *const (&previous)[2],
+                                  std::vector<int> &movingPerRow) const {
+    movingPerRow.assign(blockRows, 0);
+    if (blockRows == 0 || blocksAcross == 0) return false;
+
+    const qint32 fieldWidth = FieldWidth > 0 ? FieldWidth : videoParameters.fieldWidth;
+    const qsizetype needed = static_cast<qsizetype>(fieldWidth) *
+        (firstFieldLine + blockRows * BLOCK_LINES);
+    for (int f = 0; f < 2; f++) {
+        if (current[f]->size() < needed || previous[f]->size() < needed) return false;
+    }
+
+    for (int f = 0; f < 2; f++) {
+        const quint16 *cur = current[f]->constData();
+        const quint16 *prev = previous[f]->constData();
+        for (int row = 0; row < blockRows; row++) {
+            const qsizetype rowStart = static_cast<qsizetype>(firstFieldLine + row * BLOCK_LINES)
+                * fieldWidth + videoParameters.activeVideoStart;
+            int moving = 0;
+            for (int bx = 0; bx < blocksAcross; bx++) {
+                const qsizetype offset = rowStart + bx * BLOCK_WIDTH;
+                if (blockSad(cur + offset, prev + offset, fieldWidth) > threshold) moving++;
+            }
+            movingPerRow[row] += moving;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+ * motiondetector.h
+ * vapoursynth-analog - Block motion between frames of raw TBC fields
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef MOTIONDETECTOR_H
+#define MOTIONDETECTOR_H
+
+#include "lddecodemetadata.h"
+#include "sourcevideo.h"
+
+#include <vector>
+
+// Finds the blocks of a frame that moved since the previous frame, for
+// motion_skip, from the raw fields before any decoding. Blocks are 16
+// samples by 4 field lines over the active area of the video parameters
+// given. Each line of a block is compared as four averages of 4 samples,
+// one subcarrier cycle at 4fsc, so chroma cancels and frames a frame apart
+// compare despite their opposite subcarrier phase. A block moved if the
+// sum of absolute differences (SAD) of its averages exceeds a few IRE on
+// average.
+class MotionDetector {
+public:
+    static constexpr int BLOCK_WIDTH = 16;
+    static constexpr int BLOCK_LINES = 4;  // Field lines (8 frame lines)
+
+    explicit MotionDetector(const LdDecodeMetaData::VideoParameters &videoParams);
+
+    // Rows of blocks, each covering BLOCK_LINES lines of both fields from
+    // frame line getFirstFrameLine(), and blocks in each (per field)
+    int getBlockRows() const { return blockRows; }
+    int getBlocksAcross() const { return blocksAcross; }
+    qint32 getFirstFrameLine() const { return 2 * firstFieldLine; }
+
+    // Count the moving blocks of each row of blocks (of both fields) into
+    // movingPerRow, comparing a frame's fields with the previous frame's
+    // of the same parity. Returns false if the fields are too short.
+    bool detect(const SourceVideo::Data *const (&current)[2],
+                const SourceVideo::Data *const (&previous)[2],
+                std::vector<int> &movingPerRow) const;
+
+private:
+    LdDecodeMetaData::VideoParameters videoParameters;
+    qint32 firstFieldLine;
+    int blockRows;
+    int blocksAcross;
+    qint32 threshold;  // Block SADs above this moved
+
+    // detectFields instantiated for the field size (see fieldgeometry.h)
+    bool (MotionDetector::*detectFn)(const SourceVideo::Data *const (&)[2],
+                                     const SourceVideo::Data *const (&)[2],
+                                     std::vector<int> &) const;
+
+    template <qint32 FieldWidth>
+    bool detectFields(const SourceVideo::Data *const (&current)[2],
+                      const SourceVideo::Data *const (&previous)[2],
+                      std::vector<int> &movingPerRow) const;
+};
+
+#endif // MOTIONDETECTOR_H
@@ -0,0 +1,160 @@
+/******************************************************************************
+ * pipefieldsource.cpp
+ * vapoursynth-analog - Sequential TBC field input from a pipe or FIFO
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "pipefieldsource.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+bool isPipeInput(const std::filesystem::path &path) {
+    if (path == "-") return true;
+    std::error_code ec;
+    return std::filesystem::is_fifo(path, ec);
+}
+
+struct PipeFieldSource::Stream {
+    std::FILE *file = nullptr;
+    bool ownsFile = false;  // False for standard input
+    qint32 fieldLength = 0;
+    qint32 keepBehind = 0;
+    qint32 readAhead = 0;
+
+    std::mutex mutex;
+    std::condition_variable fieldRead;     // Reader thread added a field or stopped
+    std::condition_variable fieldWanted;   // A request moved the window forward
+    std::deque<SourceVideo::Data> fields;  // Buffered fields, oldest first
+    qint32 firstBufferedField = 1;         // Sequence number of fields.front()
+    qint32 newestRequested = 0;
+    bool endOfStream = false;
+    bool stopping = false;
+
+    ~Stream() {
+        if (file && ownsFile) std::fclose(file);
+    }
+};
+
+PipeFieldSource::~PipeFieldSource() {
+    close();
+}
+
+bool PipeFieldSource::open(const std::filesystem::path &path, qint32 fieldLength,
+                           qint32 keepBehind, qint32 readAhead) {
+    close();
+
+    auto newStream = std::make_shared<Stream>();
+    if (path == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        newStream->file = stdin;
+    } else {
+#ifdef _WIN32
+        newStream->file = _wfopen(path.c_str(), L"rb");
+#else
+        newStream->file = std::fopen(path.c_str(), "rb");
+#endif
+        newStream->ownsFile = true;
+    }
+    if (!newStream->file) {
+        lastError = "Failed to open TBC pipe: " + QString::fromStdString(path.string());
+        return false;
+    }
+    newStream->fieldLength = fieldLength;
+    newStream->keepBehind = keepBehind;
+    newStream->readAhead = readAhead;
+
+    stream = newStream;
+    std::thread(readLoop, std::move(newStream)).detach();
+    return true;
+}
+
+void PipeFieldSource::close() {
+    if (!stream) return;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->stopping = true;
+        stream->fields.clear();
+    }
+    stream->fieldWanted.notify_all();
+    // The reader thread drops its reference (closing the file) once its
+    // current read returns
+    stream.reset();
+}
+
+bool PipeFieldSource::getVideoField(qint32 fieldNo, SourceVideo::Data &data) {
+    if (!stream) {
+        lastError = "TBC pipe not open";
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    if (fieldNo > stream->newestRequested) {
+        stream->newestRequested = fieldNo;
+        stream->fieldWanted.notify_all();
+    }
+    if (fieldNo < stream->firstBufferedField) {
+        lastError = "Pipe input is sequential: field " + QString::number(fieldNo) +
+                    " is no longer buffered";
+        return false;
+    }
+
+    const auto available = [&]() {
+        return fieldNo < stream->firstBufferedField + static_cast<qint32>(stream->fields.size());
+    };
+    stream->fieldRead.wait(lock, [&]() { return available() || stream->endOfStream; });
+    if (!available()) {
+        lastError = "TBC pipe ended before field " + QString::number(fieldNo);
+        return false;
+    }
+    data = stream->fields[fieldNo - stream->firstBufferedField];
+    return true;
+}
+
+void PipeFieldSource::readLoop(std::shared_ptr<Stream> stream) {
+    const size_t fieldBytes = static_cast<size_t>(stream->fieldLength) * sizeof(quint16);
+
+    while (true) {
+        {
+            // Drop fields that fell behind the window, then wait until the
+            // window has room ahead
+            std::unique_lock<std::mutex> lock(stream->mutex);
+            stream->fieldWanted.wait(lock, [&]() {
+                while (!stream->fields.empty() &&
+                       stream->firstBufferedField < stream->newestRequested - stream->keepBehind) {
+                    stream->fields.pop_front();
+                    stream->firstBufferedField++;
+                }
+                const qint32 nextField = stream->firstBufferedField +
+                                         static_cast<qint32>(stream->fields.size());
+                return stream->stopping ||
+                       nextField <= stream->newestRequested + stream->readAhead;
+            });
+            if (stream->stopping) return;
+        }
+
+        // Read outside the lock so requests for buffered fields don't wait
+        SourceVideo::Data field(stream->fieldLength);
+        const size_t bytesRead = std::fread(field.data(), 1, fieldBytes, stream->file);
+
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        if (bytesRead < fieldBytes) {
+            stream->endOfStream = true;
+            stream->fieldRead.notify_all();
+            return;
+        }
+        stream->fields.push_back(std::move(field));
+        stream->fieldRead.notify_all();
+    }
+}
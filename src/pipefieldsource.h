@@ -0,0 +1,56 @@
+/******************************************************************************
+ * pipefieldsource.h
+ * vapoursynth-analog - Sequential TBC field input from a pipe or FIFO
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef PIPEFIELDSOURCE_H
+#define PIPEFIELDSOURCE_H
+
+#include <filesystem>
+#include <memory>
+
+#include <QString>
+
+#include "sourcevideo.h"
+
+// Whether a TBC path names sequential input: "-" (standard input) or a FIFO
+bool isPipeInput(const std::filesystem::path &path);
+
+// Reads TBC fields from a pipe on a background thread into a bounded ring
+// buffer, so a decoder (e.g. vhs-decode) can stream straight into a decode
+// without an intermediate file. Only a window of fields around the most
+// recently requested one is kept: keepBehind fields before it, for the
+// decoder's look-behind/look-ahead and slightly out-of-order requests, and
+// up to readAhead fields after it, read while earlier frames decode.
+class PipeFieldSource {
+public:
+    PipeFieldSource() = default;
+    ~PipeFieldSource();
+
+    PipeFieldSource(const PipeFieldSource &) = delete;
+    PipeFieldSource &operator=(const PipeFieldSource &) = delete;
+
+    // Start reading fields of fieldLength samples from path
+    bool open(const std::filesystem::path &path, qint32 fieldLength,
+              qint32 keepBehind, qint32 readAhead);
+    void close();
+
+    // Get a field by 1-based sequence number, waiting for it to arrive.
+    // Fails if the field has left the buffer or the stream ends first.
+    bool getVideoField(qint32 fieldNo, SourceVideo::Data &data);
+
+    QString getLastError() const { return lastError; }
+
+private:
+    // State shared with the reader thread, which may outlive this object
+    // while blocked on a pipe that never delivers another byte
+    struct Stream;
+    std::shared_ptr<Stream> stream;
+    QString lastError;
+
+    static void readLoop(std::shared_ptr<Stream> stream);
+};
+
+#endif // PIPEFIELDSOURCE_H
@@ -7,10 +7,21 @@
 
 #include "version.h"
 #include "analog4fsc.h"
+#include "correctedtbcwriter.h"
 #include "dropoutcorrector.h"
+#include "framemetrics.h"
+#include "pipefieldsource.h"
+#include "sourcecache.h"
+#include "thumbnailindex.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
 
 #include <VapourSynth4.h>
 #include <VSHelper4.h>
@@ -26,75 +37,295 @@ static int fakeArgc = 1;
 static char fakeArgv0[] = "vsanalog";
 static char *fakeArgv[] = { fakeArgv0, nullptr };
 
+static std::once_flag qtInitFlag;
+
+// Sources may be created from several threads at once (decode_many)
 static void ensureQtInitialized() {
-    if (!QCoreApplication::instance()) {
-        new QCoreApplication(fakeArgc, fakeArgv);
-    }
+    std::call_once(qtInitFlag, []() {
+        if (!QCoreApplication::instance()) {
+            new QCoreApplication(fakeArgc, fakeArgv);
+        }
+    });
 }
 
-// Decode configuration data passed to filter callbacks
+// Dropout-corrected frames each cached source keeps for reuse, so that frames
+// revisited after a script reload skip correction. Roughly 15 MiB of NTSC
+// fields (more for PAL) per source and Y/C component.
+static constexpr int CACHED_SOURCE_CORRECTED_FRAMES = 32;
+
+// Clips decode_4fsc_video can return (outputs argument)
+enum class OutputKind {
+    Video,        // Decoded video
+    DropoutMask,  // GRAY8 dropout mask (see VSAnalogAuxPlanes)
+    Raw,          // GRAY16 composite (or luma) samples
+};
+static constexpr int NUM_OUTPUT_KINDS = 3;
+
+// Frames made by one output's decode for the other outputs are queued until
+// those request them. Downstream filters normally fetch frame n of every
+// output close together, so a short queue suffices; evicted frames are
+// decoded again if requested.
+static constexpr size_t MAX_PENDING_FRAMES = 8;
+
+// Decodes of repeated pictures kept for their repeats. With fmParallel,
+// requests for a few runs (or both fields of a run) are in flight at once.
+static constexpr size_t MAX_REPEAT_FRAMES = 4;
+
+// Decode configuration data shared by the filter callbacks of all outputs
 struct DecodeConfig {
     VSVideoInfo VI = {};
-    std::unique_ptr<VSAnalog4fscSource> V;
+    VSVideoFormat maskFormat = {};
+    VSVideoFormat rawFormat = {};
+    std::shared_ptr<VSAnalog4fscSource> V;  // Shared with the source cache when enabled
+    const VSAPI *vsapi = nullptr;           // For releasing held frames
     int64_t FPSNum = -1;
     int64_t FPSDen = -1;
     bool isMono = false;              // True when using mono decoder (GRAYS output)
     bool isNTSCChromaticity = false;  // True for NTSC/PAL-M, false for PAL
     int firstActiveFrameLine = 0;  // For field order calculation
+    bool progressive = false;      // Frames are woven film frames (ivtc)
+    bool fieldOutput = false;      // Frames are single fields (field_output)
+    bool isRGB = false;            // R′G′B′ output (output_format)
+    bool matrixBT709 = false;      // Y′CbCr output re-matrixed to BT.709
     int sarNum = 1;                // Sample aspect ratio numerator
     int sarDen = 1;                // Sample aspect ratio denominator
     bool dropoutCorrect = false;   // Whether dropout correction is enabled
+    bool frameMetrics = false;     // Whether luma statistics are attached (frame_metrics)
+    std::vector<OutputKind> outputs = { OutputKind::Video };
+
+    // Repeated-picture reuse (reuse_repeats): the frame each frame repeats,
+    // and the most recent decodes of repeated pictures, most recent first
+    std::vector<int> repeatSources;   // Empty when disabled
+    struct RepeatFrame {
+        int n;
+        const VSFrame *frame;
+    };
+    std::mutex repeatMutex;
+    std::deque<RepeatFrame> repeatFrames;
+
+    // Frames decoded for outputs that haven't requested them yet
+    struct PendingFrame {
+        int n;
+        OutputKind kind;
+        const VSFrame *frame;
+    };
+    std::mutex pendingMutex;
+    std::deque<PendingFrame> pending;
+
+    // Frames being decoded, under pendingMutex. Another output requesting
+    // one waits for its decode rather than decoding it again.
+    std::set<int> decoding;
+    std::condition_variable decodeFinished;
+
+    ~DecodeConfig() {
+        for (const RepeatFrame &r : repeatFrames)
+            vsapi->freeFrame(r.frame);
+        for (const PendingFrame &p : pending)
+            vsapi->freeFrame(p.frame);
+    }
 };
 
+// Instance data of one output's filter
+struct OutputNode {
+    std::shared_ptr<DecodeConfig> D;
+    OutputKind kind;
+};
+
+// Copy of a decoded frame served for frame n, which repeats its picture.
+// The picture's statistics carry over; it is unchanged from the frame before.
+static const VSFrame *makeRepeatFrame(const DecodeConfig *D, const VSFrame *source,
+                                      int sourceFrameNumber, VSCore *core, const VSAPI *vsapi) {
+    VSFrame *repeat = vsapi->copyFrame(source, core);
+    VSMap *props = vsapi->getFramePropertiesRW(repeat);
+    vsapi->mapSetInt(props, "AnalogRepeatOf", sourceFrameNumber, maReplace);
+    if (D->frameMetrics)
+        vsapi->mapSetFloat(props, "AnalogLumaDiff", 0.0, maReplace);
+    return repeat;
+}
+
+// Keep the decode of frame n for its repeats, unless another request
+// decoded it meanwhile, evicting the least recently kept decode
+static void keepRepeatFrame(DecodeConfig *D, int n, const VSFrame *frame, const VSAPI *vsapi) {
+    std::lock_guard<std::mutex> lock(D->repeatMutex);
+    for (const DecodeConfig::RepeatFrame &r : D->repeatFrames) {
+        if (r.n == n)
+            return;
+    }
+    D->repeatFrames.push_front({n, vsapi->addFrameRef(frame)});
+    if (D->repeatFrames.size() > MAX_REPEAT_FRAMES) {
+        vsapi->freeFrame(D->repeatFrames.back().frame);
+        D->repeatFrames.pop_back();
+    }
+}
+
+// Remove and return a queued frame, waiting for a decode of frame n already
+// under way. If there is none, the caller is recorded as decoding n (until
+// it calls finishDecoding) and null is returned.
+static const VSFrame *takePendingFrame(DecodeConfig *D, int n, OutputKind kind) {
+    std::unique_lock<std::mutex> lock(D->pendingMutex);
+    for (;;) {
+        for (auto it = D->pending.begin(); it != D->pending.end(); ++it) {
+            if (it->n == n && it->kind == kind) {
+                const VSFrame *frame = it->frame;
+                D->pending.erase(it);
+                return frame;
+            }
+        }
+        // A finished decode that queued nothing for this output (it failed,
+        // or was this output's own) leaves the decode to the caller
+        if (D->decoding.insert(n).second) {
+            return nullptr;
+        }
+        D->decodeFinished.wait(lock);
+    }
+}
+
+// End the caller's decode of frame n, after queueing its frames
+static void finishDecoding(DecodeConfig *D, int n) {
+    {
+        std::lock_guard<std::mutex> lock(D->pendingMutex);
+        D->decoding.erase(n);
+    }
+    D->decodeFinished.notify_all();
+}
+
+static void addPendingFrame(DecodeConfig *D, int n, OutputKind kind, const VSFrame *frame,
+                            const VSAPI *vsapi) {
+    std::lock_guard<std::mutex> lock(D->pendingMutex);
+    for (const DecodeConfig::PendingFrame &p : D->pending) {
+        if (p.n == n && p.kind == kind) {
+            // Already queued by an earlier decode
+            vsapi->freeFrame(frame);
+            return;
+        }
+    }
+    D->pending.push_back({n, kind, frame});
+    while (D->pending.size() > MAX_PENDING_FRAMES * (D->outputs.size() - 1)) {
+        vsapi->freeFrame(D->pending.front().frame);
+        D->pending.pop_front();
+    }
+}
+
 // Frame getter callback
 static const VSFrame *VS_CC VSAnalog4fscSourceGetFrame(
     int n, int activationReason, void *instanceData, void **,
     VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi
 ) {
-    auto *D = static_cast<DecodeConfig *>(instanceData);
+    auto *node = static_cast<OutputNode *>(instanceData);
+    DecodeConfig *D = node->D.get();
 
     if (activationReason != arInitial) {
         return nullptr;
     }
 
-    // Create the output frame
-    VSFrame *dst = vsapi->newVideoFrame(&D->VI.format, D->VI.width, D->VI.height, nullptr, core);
-    if (!dst) {
-        vsapi->setFilterError("Failed to allocate output frame", frameCtx);
-        return nullptr;
+    // Another output's decode may have made this frame already, or be
+    // making it now. Otherwise this decode is recorded until it returns.
+    struct DecodingClaim {
+        DecodeConfig *D = nullptr;
+        int n = -1;
+        ~DecodingClaim() { if (D) finishDecoding(D, n); }
+    } claim;
+    if (D->outputs.size() > 1) {
+        if (const VSFrame *pending = takePendingFrame(D, n, node->kind)) {
+            return pending;
+        }
+        claim = {D, n};
+    }
+
+    // Frames repeating an earlier picture are served from its decode while
+    // it's cached. A run's source frame is kept when repeats follow it
+    // (with field output, the next field of the same parity).
+    int decodeN = n;
+    bool keepDecoded = false;
+    if (n < static_cast<int>(D->repeatSources.size())) {
+        const int next = n + (D->fieldOutput ? 2 : 1);
+        decodeN = D->repeatSources[n];
+        keepDecoded = node->kind == OutputKind::Video && (decodeN != n ||
+            (next < static_cast<int>(D->repeatSources.size()) && D->repeatSources[next] == n));
+
+        if (keepDecoded && decodeN != n) {
+            std::lock_guard<std::mutex> lock(D->repeatMutex);
+            for (const DecodeConfig::RepeatFrame &r : D->repeatFrames) {
+                if (r.n == decodeN)
+                    return makeRepeatFrame(D, r.frame, decodeN, core, vsapi);
+            }
+        }
+    }
+
+    // Create the output frames. The video is always decoded; the other
+    // outputs are drawn from the same decode.
+    VSFrame *frames[NUM_OUTPUT_KINDS] = {};
+    auto freeFrames = [&]() {
+        for (VSFrame *frame : frames) {
+            if (frame)
+                vsapi->freeFrame(frame);
+        }
+    };
+    frames[static_cast<int>(OutputKind::Video)] =
+        vsapi->newVideoFrame(&D->VI.format, D->VI.width, D->VI.height, nullptr, core);
+    for (OutputKind kind : D->outputs) {
+        if (kind == OutputKind::DropoutMask)
+            frames[static_cast<int>(kind)] =
+                vsapi->newVideoFrame(&D->maskFormat, D->VI.width, D->VI.height, nullptr, core);
+        else if (kind == OutputKind::Raw)
+            frames[static_cast<int>(kind)] =
+                vsapi->newVideoFrame(&D->rawFormat, D->VI.width, D->VI.height, nullptr, core);
+    }
+    for (OutputKind kind : D->outputs) {
+        if (!frames[static_cast<int>(kind)]) {
+            freeFrames();
+            vsapi->setFilterError("Failed to allocate output frame", frameCtx);
+            return nullptr;
+        }
     }
+    VSFrame *dst = frames[static_cast<int>(OutputKind::Video)];
+    VSFrame *maskFrame = frames[static_cast<int>(OutputKind::DropoutMask)];
+    VSFrame *rawFrame = frames[static_cast<int>(OutputKind::Raw)];
 
     // Get write pointers and strides for each plane
-    auto *yData = reinterpret_cast<float *>(vsapi->getWritePtr(dst, 0));
+    uint8_t *yData = vsapi->getWritePtr(dst, 0);
     ptrdiff_t yStride = vsapi->getStride(dst, 0);
 
-    // For mono output, we only have Y plane; for YUV we have all three
-    float *uData = nullptr;
-    float *vData = nullptr;
+    // For mono output, we only have Y plane; for YUV or RGB we have all three
+    uint8_t *uData = nullptr;
+    uint8_t *vData = nullptr;
     ptrdiff_t uStride = 0;
     ptrdiff_t vStride = 0;
 
     if (!D->isMono) {
-        uData = reinterpret_cast<float *>(vsapi->getWritePtr(dst, 1));
-        vData = reinterpret_cast<float *>(vsapi->getWritePtr(dst, 2));
+        uData = vsapi->getWritePtr(dst, 1);
+        vData = vsapi->getWritePtr(dst, 2);
         uStride = vsapi->getStride(dst, 1);
         vStride = vsapi->getStride(dst, 2);
     }
 
+    VSAnalogAuxPlanes aux;
+    if (maskFrame) {
+        aux.dropoutMask = vsapi->getWritePtr(maskFrame, 0);
+        aux.dropoutMaskStride = static_cast<int>(vsapi->getStride(maskFrame, 0));
+    }
+    if (rawFrame) {
+        aux.raw = vsapi->getWritePtr(rawFrame, 0);
+        aux.rawStride = static_cast<int>(vsapi->getStride(rawFrame, 0));
+    }
+
     // Decode the frame
     DropoutCorrectionStats docStats;
+    FrameMetrics metrics;
     try {
-        if (!D->V->GetFrame(n, yData, uData, vData,
+        if (!D->V->GetFrame(decodeN, yData, uData, vData,
                            static_cast<int>(yStride),
                            static_cast<int>(uStride),
                            static_cast<int>(vStride),
-                           D->dropoutCorrect ? &docStats : nullptr)) {
-            vsapi->freeFrame(dst);
+                           D->dropoutCorrect ? &docStats : nullptr,
+                           (maskFrame || rawFrame) ? &aux : nullptr,
+                           D->frameMetrics ? &metrics : nullptr)) {
+            freeFrames();
             vsapi->setFilterError("Failed to decode frame", frameCtx);
             return nullptr;
         }
     } catch (const std::exception &e) {
-        vsapi->freeFrame(dst);
+        freeFrames();
         vsapi->setFilterError(e.what(), frameCtx);
         return nullptr;
     }
@@ -108,6 +339,8 @@ static const VSFrame *VS_CC VSAnalog4fscSourceGetFrame(
     // Assume BT.709/BT.1886 for both: _Transfer=1
     // In the future, we may bring on _Primaries=4 (NTSC-1953) as an
     // alternative to _Primaries=6 (ST 170).
+    // R′G′B′ output has no matrix (_Matrix=0); BT.709-matrixed output
+    // keeps the source primaries but has _Matrix=1.
     if (D->isNTSCChromaticity) {
         vsapi->mapSetInt(props, "_Primaries", 6, maReplace);
         vsapi->mapSetInt(props, "_Matrix", 6, maReplace);
@@ -115,6 +348,11 @@ static const VSFrame *VS_CC VSAnalog4fscSourceGetFrame(
         vsapi->mapSetInt(props, "_Primaries", 5, maReplace);
         vsapi->mapSetInt(props, "_Matrix", 5, maReplace);
     }
+    if (D->isRGB) {
+        vsapi->mapSetInt(props, "_Matrix", 0, maReplace);
+    } else if (D->matrixBT709) {
+        vsapi->mapSetInt(props, "_Matrix", 1, maReplace);
+    }
     vsapi->mapSetInt(props, "_Transfer", 1, maReplace);
 
     // Most video pipelines don't have a concept of limited-range
@@ -127,40 +365,115 @@ static const VSFrame *VS_CC VSAnalog4fscSourceGetFrame(
     // a within-matrix conversion target range, we'll mark it as limited so
     // that downstream conversions to integer Y′CbCr samples will stay marked
     // as limited without the user needing to specify.
+    // R′G′B′ output is full range: black at 0, white at 1.0 (or 255).
     // AviSynth-style range property:
-    vsapi->mapSetInt(props, "_ColorRange", 1, maReplace);
+    vsapi->mapSetInt(props, "_ColorRange", D->isRGB ? 0 : 1, maReplace);
     // ITU H.273 code point as used by resize plugin (zimg):
-    vsapi->mapSetInt(props, "_Range", 0, maReplace);
+    vsapi->mapSetInt(props, "_Range", D->isRGB ? 1 : 0, maReplace);
+
+    // Mask and raw samples aren't video levels; mark them full range
+    for (VSFrame *auxFrame : { maskFrame, rawFrame }) {
+        if (auxFrame) {
+            VSMap *auxProps = vsapi->getFramePropertiesRW(auxFrame);
+            vsapi->mapSetInt(auxProps, "_ColorRange", 0, maReplace);
+            vsapi->mapSetInt(auxProps, "_Range", 1, maReplace);
+        }
+    }
 
-    // Field order - matches ld-chroma-decoder's Y4M output logic
-    // Ib (bottom field first) = 1, It (top field first) = 2
-    // Logic: if (firstActiveFrameLine % 2) is odd -> BFF, else TFF
-    // (We don't have padding, so topPadLines is always 0)
-    int fieldBased = (D->firstActiveFrameLine % 2 == 1) ? 1 : 2;
-    vsapi->mapSetInt(props, "_FieldBased", fieldBased, maReplace);
+    // Timing, field and dropout properties apply to every output
+    for (VSFrame *frame : frames) {
+        if (!frame)
+            continue;
+        VSMap *frameProps = vsapi->getFramePropertiesRW(frame);
 
-    // Sample Aspect Ratio based on sampling and video system
-    vsapi->mapSetInt(props, "_SARNum", D->sarNum, maReplace);
-    vsapi->mapSetInt(props, "_SARDen", D->sarDen, maReplace);
+        // Field order - matches ld-chroma-decoder's Y4M output logic
+        // Ib (bottom field first) = 1, It (top field first) = 2
+        // Logic: if (firstActiveFrameLine % 2) is odd -> BFF, else TFF
+        // (We don't have padding, so topPadLines is always 0)
+        // Film frames woven by inverse telecine and separated fields are
+        // progressive (0)
+        int fieldBased = (D->progressive || D->fieldOutput) ? 0
+            : (D->firstActiveFrameLine % 2 == 1) ? 1 : 2;
+        vsapi->mapSetInt(frameProps, "_FieldBased", fieldBased, maReplace);
 
-    // Analog SD video systems are constant frame rate, at least when
-    // time-base-corrected, so inverting the clip fps is sane
-    vsapi->mapSetInt(props, "_DurationNum", D->VI.fpsDen, maReplace);
-    vsapi->mapSetInt(props, "_DurationDen", D->VI.fpsNum, maReplace);
+        // Separated fields: even frames hold the first field (even frame lines),
+        // which is the top field when the active area starts on an even line.
+        // _Field follows SeparateFields: 1 = top, 0 = bottom.
+        if (D->fieldOutput) {
+            const bool topField = (n % 2) == (D->firstActiveFrameLine % 2);
+            vsapi->mapSetInt(frameProps, "_Field", topField ? 1 : 0, maReplace);
+        }
+
+        // Sample Aspect Ratio based on sampling and video system
+        vsapi->mapSetInt(frameProps, "_SARNum", D->sarNum, maReplace);
+        vsapi->mapSetInt(frameProps, "_SARDen", D->sarDen, maReplace);
+
+        // Analog SD video systems are constant frame rate, at least when
+        // time-base-corrected, so inverting the clip fps is sane
+        vsapi->mapSetInt(frameProps, "_DurationNum", D->VI.fpsDen, maReplace);
+        vsapi->mapSetInt(frameProps, "_DurationDen", D->VI.fpsNum, maReplace);
+
+        // Dropout correction statistics (only set when correction is enabled)
+        if (D->dropoutCorrect) {
+            vsapi->mapSetInt(frameProps, "AnalogDropoutsCorrected", docStats.corrected, maReplace);
+            vsapi->mapSetInt(frameProps, "AnalogDropoutsFailed", docStats.failed, maReplace);
+            vsapi->mapSetInt(frameProps, "AnalogDropoutsTotalDistance", docStats.totalDistance, maReplace);
+        }
+
+        // Repeats are decoded from their source frame (the video copy
+        // kept for reuse gets its props on the copy made below)
+        const bool repeat = decodeN != n && !(frame == dst && keepDecoded);
+
+        // Luma statistics and comb metrics gathered during the output pass.
+        // A repeat's picture statistics are its source frame's, and its
+        // picture is unchanged from the frame before.
+        if (D->frameMetrics) {
+            vsapi->mapSetFloat(frameProps, "AnalogLumaAverage", metrics.lumaAverage, maReplace);
+            vsapi->mapSetFloat(frameProps, "AnalogLumaMin", metrics.lumaMin, maReplace);
+            vsapi->mapSetFloat(frameProps, "AnalogLumaMax", metrics.lumaMax, maReplace);
+            vsapi->mapSetIntArray(frameProps, "AnalogLumaHistogram", metrics.histogram,
+                                  FrameMetrics::HISTOGRAM_BINS);
+            if (repeat)
+                vsapi->mapSetFloat(frameProps, "AnalogLumaDiff", 0.0, maReplace);
+            else if (metrics.lumaDiff >= 0.0)
+                vsapi->mapSetFloat(frameProps, "AnalogLumaDiff", metrics.lumaDiff, maReplace);
+            if (metrics.hasComb) {
+                vsapi->mapSetInt(frameProps, "AnalogCombMax", metrics.combMax, maReplace);
+                vsapi->mapSetFloat(frameProps, "AnalogCombFraction", metrics.combFraction, maReplace);
+            }
+        }
+
+        if (repeat)
+            vsapi->mapSetInt(frameProps, "AnalogRepeatOf", decodeN, maReplace);
+    }
+
+    // Queue the other outputs' frames; the video is dropped unless returned
+    const VSFrame *result = frames[static_cast<int>(node->kind)];
+    for (OutputKind kind : D->outputs) {
+        if (kind != node->kind)
+            addPendingFrame(D, n, kind, frames[static_cast<int>(kind)], vsapi);
+    }
+    if (node->kind != OutputKind::Video &&
+        std::find(D->outputs.begin(), D->outputs.end(), OutputKind::Video) == D->outputs.end()) {
+        vsapi->freeFrame(dst);
+    }
 
-    // Dropout correction statistics (only set when correction is enabled)
-    if (D->dropoutCorrect) {
-        vsapi->mapSetInt(props, "AnalogDropoutsCorrected", docStats.corrected, maReplace);
-        vsapi->mapSetInt(props, "AnalogDropoutsFailed", docStats.failed, maReplace);
-        vsapi->mapSetInt(props, "AnalogDropoutsTotalDistance", docStats.totalDistance, maReplace);
+    if (keepDecoded) {
+        keepRepeatFrame(D, decodeN, dst, vsapi);
+        if (decodeN != n) {
+            const VSFrame *repeat = makeRepeatFrame(D, dst, decodeN, core, vsapi);
+            vsapi->freeFrame(dst);
+            return repeat;
+        }
     }
 
-    return dst;
+    return result;
 }
 
 // Cleanup callback
 static void VS_CC VSAnalog4fscSourceFree(void *instanceData, VSCore *, const VSAPI *) {
-    delete static_cast<DecodeConfig *>(instanceData);
+    // The shared decode configuration goes with the last output's node
+    delete static_cast<OutputNode *>(instanceData);
 }
 
 // Filter creation function
@@ -186,16 +499,22 @@ static void VS_CC Create4fscSource(const VSMap *In, VSMap *Out, void *, VSCore *
         hasChromaSource = true;
     }
 
-    // Get optional Pr source path (for component video - not yet supported)
+    // Get optional Pr source path (for component video, with Pb as the chroma source)
     const char *RawPrPath = vsapi->mapGetData(In, "pr_source", 0, &err);
+    std::filesystem::path PrSource;
+    bool hasPrSource = false;
     if (!err && RawPrPath) {
-        // Component video mode (all 3 sources) is not yet implemented
-        vsapi->mapSetError(Out, "decode_4fsc_video: component video mode (3 separate sources) is not yet supported");
-        return;
+        if (!hasChromaSource) {
+            vsapi->mapSetError(Out, "decode_4fsc_video: component video needs chroma_or_pb_source with pr_source");
+            return;
+        }
+        PrSource = RawPrPath;
+        hasPrSource = true;
     }
 
     std::filesystem::path Source(RawSourcePath);
-    auto *D = new DecodeConfig();
+    auto D = std::make_shared<DecodeConfig>();
+    D->vsapi = vsapi;
 
     try {
         // Parse optional parameters
@@ -247,6 +566,11 @@ static void VS_CC Create4fscSource(const VSMap *In, VSMap *Out, void *, VSCore *
         if (err)
             dropoutIntra = 0;
         Opts.dropoutIntra = (dropoutIntra != 0);
+        Opts.dropoutDetect = vsapi->mapGetIntSaturated(In, "dropout_detect", 0, &err);
+        if (err)
+            Opts.dropoutDetect = 0;
+        if (Opts.dropoutDetect < 0 || Opts.dropoutDetect > 2)
+            throw VSAnalogException("dropout_detect must be 0, 1 or 2");
 
         // Extra sources for multi-source dropout correction
         int numExtraLuma = vsapi->mapNumElements(In, "dropout_composite_or_luma_extra_sources");
@@ -262,16 +586,139 @@ static void VS_CC Create4fscSource(const VSMap *In, VSMap *Out, void *, VSCore *
                 Opts.dropoutExtraChromaSources.emplace_back(path);
         }
 
+        // Metadata sidecar (optional; needed for standard input)
+        const char *metadataPath = vsapi->mapGetData(In, "metadata", 0, &err);
+        if (!err && metadataPath)
+            Opts.metadataPath = metadataPath;
+
         // Get decoder name (optional)
         const char *decoderName = vsapi->mapGetData(In, "decoder", 0, &err);
         if (!err && decoderName)
             Opts.decoder = decoderName;
 
-        // Create the source
-        D->V = std::make_unique<VSAnalog4fscSource>(
-            Source,
-            hasChromaSource ? &ChromaSource : nullptr,
-            &Opts);
+        // Inverse telecine mode (optional)
+        const char *ivtcMode = vsapi->mapGetData(In, "ivtc", 0, &err);
+        if (!err && ivtcMode) {
+            if (std::string(ivtcMode) != "vbi")
+                throw VSAnalogException("Unknown ivtc mode '" + std::string(ivtcMode) +
+                                        "' (supported: vbi)");
+            Opts.ivtcVbi = true;
+        }
+
+        int fieldOutput = vsapi->mapGetInt(In, "field_output", 0, &err);
+        if (err)
+            fieldOutput = 0;
+        Opts.fieldOutput = (fieldOutput != 0);
+
+        // Output format and matrix (optional)
+        const char *outputFormat = vsapi->mapGetData(In, "output_format", 0, &err);
+        if (!err && outputFormat) {
+            const std::string format(outputFormat);
+            if (format == "yuv444ps")
+                Opts.outputFormat = VSAnalogOutputFormat::YUV444PS;
+            else if (format == "yuv444ph")
+                Opts.outputFormat = VSAnalogOutputFormat::YUV444PH;
+            else if (format == "rgbs")
+                Opts.outputFormat = VSAnalogOutputFormat::RGBS;
+            else if (format == "rgb24")
+                Opts.outputFormat = VSAnalogOutputFormat::RGB24;
+            else
+                throw VSAnalogException("Unknown output_format '" + format +
+                                        "' (supported: yuv444ps, yuv444ph, rgbs, rgb24)");
+        }
+        const char *matrix = vsapi->mapGetData(In, "matrix", 0, &err);
+        if (!err && matrix) {
+            const std::string matrixName(matrix);
+            if (matrixName == "709")
+                Opts.matrixBT709 = true;
+            else if (matrixName != "source")
+                throw VSAnalogException("Unknown matrix '" + matrixName +
+                                        "' (supported: source, 709)");
+        }
+
+        // Crop of the active area (optional)
+        Opts.cropLeft = vsapi->mapGetIntSaturated(In, "crop_left", 0, &err);
+        if (err)
+            Opts.cropLeft = 0;
+        Opts.cropTop = vsapi->mapGetIntSaturated(In, "crop_top", 0, &err);
+        if (err)
+            Opts.cropTop = 0;
+        Opts.cropRight = vsapi->mapGetIntSaturated(In, "crop_right", 0, &err);
+        if (err)
+            Opts.cropRight = 0;
+        Opts.cropBottom = vsapi->mapGetIntSaturated(In, "crop_bottom", 0, &err);
+        if (err)
+            Opts.cropBottom = 0;
+
+        // Clips to return (optional), all fed by one decode per frame
+        int numOutputs = vsapi->mapNumElements(In, "outputs");
+        if (numOutputs > 0) {
+            D->outputs.clear();
+            for (int i = 0; i < numOutputs; i++) {
+                const std::string output(vsapi->mapGetData(In, "outputs", i, &err));
+                OutputKind kind;
+                if (output == "video")
+                    kind = OutputKind::Video;
+                else if (output == "dropout_mask")
+                    kind = OutputKind::DropoutMask;
+                else if (output == "raw")
+                    kind = OutputKind::Raw;
+                else
+                    throw VSAnalogException("Unknown output '" + output +
+                                            "' (supported: video, dropout_mask, raw)");
+                if (std::find(D->outputs.begin(), D->outputs.end(), kind) != D->outputs.end())
+                    throw VSAnalogException("Output '" + output + "' is requested more than once");
+                D->outputs.push_back(kind);
+            }
+        }
+
+        Opts.motionSkip = vsapi->mapGetFloat(In, "motion_skip", 0, &err);
+        if (err)
+            Opts.motionSkip = 0.0;
+        if (Opts.motionSkip < 0.0 || Opts.motionSkip > 1.0)
+            throw VSAnalogException("motion_skip must be between 0.0 and 1.0");
+
+        Opts.decodeThreads = vsapi->mapGetIntSaturated(In, "threads", 0, &err);
+        if (err)
+            Opts.decodeThreads = 1;
+        if (Opts.decodeThreads < -1)
+            throw VSAnalogException("threads must be -1 (autotune), 0 or positive");
+
+        int frameMetrics = vsapi->mapGetInt(In, "frame_metrics", 0, &err);
+        if (err)
+            frameMetrics = 0;
+        D->frameMetrics = (frameMetrics != 0);
+
+        int reuseRepeats = vsapi->mapGetInt(In, "reuse_repeats", 0, &err);
+        if (err)
+            reuseRepeats = 0;
+
+        int cacheSource = vsapi->mapGetInt(In, "cache", 0, &err);
+        if (err)
+            cacheSource = 0;
+
+        // Create the source, or reuse one opened by an earlier evaluation of
+        // the script when caching is requested
+        const bool pipeInput = isPipeInput(Source) ||
+            (hasChromaSource && isPipeInput(ChromaSource)) ||
+            (hasPrSource && isPipeInput(PrSource));
+        if (cacheSource && pipeInput)
+            throw VSAnalogException("Pipe input is consumed as it's read and can't be cached");
+        if (cacheSource) {
+            if (Opts.dropoutCorrect)
+                Opts.correctedFrameCacheSize = CACHED_SOURCE_CORRECTED_FRAMES;
+            D->V = VSAnalogSourceCache::acquire(
+                Source,
+                hasChromaSource ? &ChromaSource : nullptr,
+                hasPrSource ? &PrSource : nullptr,
+                Opts);
+        } else {
+            D->V = std::make_shared<VSAnalog4fscSource>(
+                Source,
+                hasChromaSource ? &ChromaSource : nullptr,
+                hasPrSource ? &PrSource : nullptr,
+                &Opts);
+        }
 
         const VSAnalogVideoProperties &VP = D->V->GetVideoProperties();
 
@@ -286,19 +733,38 @@ static void VS_CC Create4fscSource(const VSMap *In, VSMap *Out, void *, VSCore *
         D->VI.height = VP.SSModHeight;
         D->VI.numFrames = static_cast<int>(VP.NumFrames);
 
-        // Query the appropriate format from VapourSynth based on decoder type
+        // Query the appropriate format from VapourSynth based on decoder
+        // type and output format
         D->isMono = (VP.VF.ColorFamily == 1);
-        VSColorFamily colorFamily = D->isMono ? cfGray : cfYUV;
-        if (!vsapi->queryVideoFormat(&D->VI.format, colorFamily, stFloat, 32, 0, 0, Core)) {
-            throw VSAnalogException(D->isMono
-                ? "Failed to query GRAYS format"
-                : "Failed to query YUV444PS format");
+        D->isRGB = (VP.VF.ColorFamily == 2);
+        VSColorFamily colorFamily = D->isMono ? cfGray : D->isRGB ? cfRGB : cfYUV;
+        VSSampleType sampleType = (VP.VF.SampleType == 1) ? stFloat : stInteger;
+        if (!vsapi->queryVideoFormat(&D->VI.format, colorFamily, sampleType,
+                                     VP.VF.BitsPerSample, 0, 0, Core)) {
+            throw VSAnalogException("Failed to query output video format");
+        }
+        D->matrixBT709 = Opts.matrixBT709;
+        if (!vsapi->queryVideoFormat(&D->maskFormat, cfGray, stInteger, 8, 0, 0, Core) ||
+            !vsapi->queryVideoFormat(&D->rawFormat, cfGray, stInteger, 16, 0, 0, Core)) {
+            throw VSAnalogException("Failed to query output video format");
         }
 
         // Store config for frame property decisions
         D->dropoutCorrect = Opts.dropoutCorrect;
         D->isNTSCChromaticity = D->V->IsNTSCLines();
         D->firstActiveFrameLine = D->V->GetFirstActiveFrameLine();
+        D->progressive = D->V->IsIvtc();
+        D->fieldOutput = D->V->IsFieldOutput();
+        if (reuseRepeats) {
+            D->repeatSources = D->V->GetRepeatSourceFrames();
+            if (D->fieldOutput) {
+                // A field repeats the same field of its frame's source frame
+                std::vector<int> fieldSources(D->repeatSources.size() * 2);
+                for (size_t i = 0; i < fieldSources.size(); i++)
+                    fieldSources[i] = D->repeatSources[i / 2] * 2 + static_cast<int>(i % 2);
+                D->repeatSources = std::move(fieldSources);
+            }
+        }
         auto sar = D->V->GetSAR();
         D->sarNum = sar.num;
         D->sarDen = sar.den;
@@ -318,20 +784,193 @@ static void VS_CC Create4fscSource(const VSMap *In, VSMap *Out, void *, VSCore *
         }
 
     } catch (const VSAnalogException &e) {
-        delete D;
         vsapi->mapSetError(Out, (std::string("decode_4fsc_video: ") + e.what()).c_str());
         return;
     } catch (const std::exception &e) {
-        delete D;
         vsapi->mapSetError(Out, (std::string("decode_4fsc_video: ") + e.what()).c_str());
         return;
     }
 
-    // Create the video filter
-    // fmUnordered because decoding is sequential (ld-decode maintains internal state)
-    vsapi->createVideoFilter(Out, "decode_4fsc_video", &D->VI,
-                             VSAnalog4fscSourceGetFrame, VSAnalog4fscSourceFree,
-                             fmUnordered, nullptr, 0, D, Core);
+    // Create a video filter per output, in the requested order.
+    // ld-decode's decoders keep internal state, so each concurrent decode
+    // needs its own decode context; with one, decoding is sequential.
+    const VSFilterMode filterMode = D->V->GetMaxDecodeThreads() > 1 ? fmParallel : fmUnordered;
+    for (OutputKind kind : D->outputs) {
+        VSVideoInfo vi = D->VI;
+        const char *name = "decode_4fsc_video";
+        if (kind == OutputKind::DropoutMask) {
+            vi.format = D->maskFormat;
+            name = "decode_4fsc_video_dropout_mask";
+        } else if (kind == OutputKind::Raw) {
+            vi.format = D->rawFormat;
+            name = "decode_4fsc_video_raw";
+        }
+        VSNode *node = vsapi->createVideoFilter2(name, &vi,
+                                                 VSAnalog4fscSourceGetFrame, VSAnalog4fscSourceFree,
+                                                 filterMode, nullptr, 0, new OutputNode{D, kind}, Core);
+        vsapi->mapConsumeNode(Out, "clip", node, maAppend);
+    }
+}
+
+// Write a dropout-corrected copy of a TBC plus a sidecar listing only the
+// dropouts that could not be corrected
+static void VS_CC WriteCorrectedTbc(const VSMap *In, VSMap *Out, void *, VSCore *, const VSAPI *vsapi) {
+    int err;
+
+    ensureQtInitialized();
+
+    const char *RawSourcePath = vsapi->mapGetData(In, "source", 0, &err);
+    if (err || !RawSourcePath) {
+        vsapi->mapSetError(Out, "write_corrected_tbc: source path is required");
+        return;
+    }
+    const char *RawOutputPath = vsapi->mapGetData(In, "output", 0, &err);
+    if (err || !RawOutputPath) {
+        vsapi->mapSetError(Out, "write_corrected_tbc: output path is required");
+        return;
+    }
+
+    CorrectedTbcOptions Opts;
+    int numExtra = vsapi->mapNumElements(In, "extra_sources");
+    for (int i = 0; i < numExtra && numExtra > 0; i++) {
+        const char *path = vsapi->mapGetData(In, "extra_sources", i, &err);
+        if (!err && path)
+            Opts.extraSources.emplace_back(path);
+    }
+    int dropoutOvercorrect = vsapi->mapGetInt(In, "dropout_overcorrect", 0, &err);
+    if (err)
+        dropoutOvercorrect = 0;
+    Opts.dropoutOvercorrect = (dropoutOvercorrect != 0);
+    int dropoutIntra = vsapi->mapGetInt(In, "dropout_intra", 0, &err);
+    if (err)
+        dropoutIntra = 0;
+    Opts.dropoutIntra = (dropoutIntra != 0);
+    Opts.dropoutDetect = vsapi->mapGetIntSaturated(In, "dropout_detect", 0, &err);
+    if (err)
+        Opts.dropoutDetect = 0;
+    if (Opts.dropoutDetect < 0 || Opts.dropoutDetect > 2) {
+        vsapi->mapSetError(Out, "write_corrected_tbc: dropout_detect must be 0, 1 or 2");
+        return;
+    }
+    Opts.threads = vsapi->mapGetIntSaturated(In, "threads", 0, &err);
+    if (err)
+        Opts.threads = 0;
+
+    try {
+        CorrectedTbcSummary summary = writeCorrectedTbc(RawSourcePath, RawOutputPath, Opts);
+        vsapi->mapSetInt(Out, "frames_rewritten", summary.framesRewritten, maReplace);
+        vsapi->mapSetInt(Out, "dropouts_corrected", summary.stats.corrected, maReplace);
+        vsapi->mapSetInt(Out, "dropouts_failed", summary.stats.failed, maReplace);
+    } catch (const std::exception &e) {
+        vsapi->mapSetError(Out, (std::string("write_corrected_tbc: ") + e.what()).c_str());
+    }
+}
+
+// Thumbnail index clip
+struct ThumbnailConfig {
+    std::unique_ptr<ThumbnailIndex> index;
+    VSVideoInfo VI;
+};
+
+static const VSFrame *VS_CC ThumbnailsGetFrame(
+    int n, int activationReason, void *instanceData, void **,
+    VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi
+) {
+    auto *D = static_cast<ThumbnailConfig *>(instanceData);
+    if (activationReason != arInitial) {
+        return nullptr;
+    }
+
+    VSFrame *frame = vsapi->newVideoFrame(&D->VI.format, D->VI.width, D->VI.height, nullptr, core);
+    if (!frame) {
+        vsapi->setFilterError("Failed to allocate output frame", frameCtx);
+        return nullptr;
+    }
+    try {
+        D->index->getThumbnail(n, vsapi->getWritePtr(frame, 0), vsapi->getStride(frame, 0));
+    } catch (const std::exception &e) {
+        vsapi->freeFrame(frame);
+        vsapi->setFilterError(e.what(), frameCtx);
+        return nullptr;
+    }
+
+    VSMap *props = vsapi->getFramePropertiesRW(frame);
+    vsapi->mapSetInt(props, "_ColorRange", 1, maReplace);
+    vsapi->mapSetInt(props, "_Range", 0, maReplace);
+    vsapi->mapSetInt(props, "_FieldBased", 0, maReplace);
+    vsapi->mapSetInt(props, "_DurationNum", D->VI.fpsDen, maReplace);
+    vsapi->mapSetInt(props, "_DurationDen", D->VI.fpsNum, maReplace);
+    // Video frame of the TBC the thumbnail shows
+    vsapi->mapSetInt(props, "AnalogSourceFrame",
+                     static_cast<int64_t>(n) * D->index->getInterval(), maReplace);
+    return frame;
+}
+
+static void VS_CC ThumbnailsFree(void *instanceData, VSCore *, const VSAPI *) {
+    delete static_cast<ThumbnailConfig *>(instanceData);
+}
+
+// Build (or load) a thumbnail index of a TBC and expose it as a clip
+static void VS_CC CreateThumbnails(const VSMap *In, VSMap *Out, void *, VSCore *Core, const VSAPI *vsapi) {
+    int err;
+
+    ensureQtInitialized();
+
+    const char *RawSourcePath = vsapi->mapGetData(In, "source", 0, &err);
+    if (err || !RawSourcePath) {
+        vsapi->mapSetError(Out, "thumbnails: source path is required");
+        return;
+    }
+
+    ThumbnailOptions Opts;
+    Opts.interval = vsapi->mapGetIntSaturated(In, "interval", 0, &err);
+    if (err)
+        Opts.interval = ThumbnailOptions().interval;
+    Opts.width = vsapi->mapGetIntSaturated(In, "width", 0, &err);
+    if (err)
+        Opts.width = ThumbnailOptions().width;
+    Opts.threads = vsapi->mapGetIntSaturated(In, "threads", 0, &err);
+    if (err)
+        Opts.threads = 0;
+    int cache = vsapi->mapGetInt(In, "cache", 0, &err);
+    if (err)
+        cache = 1;
+    Opts.cache = (cache != 0);
+    const char *RawMetadataPath = vsapi->mapGetData(In, "metadata", 0, &err);
+    if (!err && RawMetadataPath)
+        Opts.metadataPath = RawMetadataPath;
+
+    auto D = std::make_unique<ThumbnailConfig>();
+    try {
+        D->index = std::make_unique<ThumbnailIndex>(RawSourcePath, Opts);
+    } catch (const std::exception &e) {
+        vsapi->mapSetError(Out, (std::string("thumbnails: ") + e.what()).c_str());
+        return;
+    }
+
+    if (!vsapi->queryVideoFormat(&D->VI.format, cfGray, stInteger, 8, 0, 0, Core)) {
+        vsapi->mapSetError(Out, "thumbnails: Failed to query output video format");
+        return;
+    }
+    D->VI.width = D->index->getWidth();
+    D->VI.height = D->index->getHeight();
+    D->VI.numFrames = D->index->getNumThumbnails();
+    const TbcReader::FrameRate rate = D->index->getFrameRate();
+    D->VI.fpsNum = rate.num;
+    D->VI.fpsDen = rate.den;
+    vsh::reduceRational(&D->VI.fpsNum, &D->VI.fpsDen);
+
+    // Thumbnails the background workers haven't reached are built by the
+    // requesting thread, so requests can run in parallel
+    const VSVideoInfo vi = D->VI;
+    VSNode *node = vsapi->createVideoFilter2("thumbnails", &vi, ThumbnailsGetFrame, ThumbnailsFree,
+                                             fmParallel, nullptr, 0, D.release(), Core);
+    vsapi->mapConsumeNode(Out, "clip", node, maAppend);
+}
+
+// Drop all sources kept by the process-level source cache
+static void VS_CC ClearSourceCache(const VSMap *, VSMap *, void *, VSCore *, const VSAPI *) {
+    VSAnalogSourceCache::clear();
 }
 
 // Plugin entry point
@@ -362,13 +1001,69 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit2(VSPlugin *plugin, const VSPLUGINAPI
         "dropout_correct:int:opt;"
         "dropout_overcorrect:int:opt;"
         "dropout_intra:int:opt;"
+        "dropout_detect:int:opt;"
         "dropout_composite_or_luma_extra_sources:data[]:opt;"
         "dropout_chroma_extra_sources:data[]:opt;"
         "fpsnum:int:opt;"
-        "fpsden:int:opt;",
+        "fpsden:int:opt;"
+        "cache:int:opt;"
+        "ivtc:data:opt;"
+        "reuse_repeats:int:opt;"
+        "field_output:int:opt;"
+        "output_format:data:opt;"
+        "matrix:data:opt;"
+        "crop_left:int:opt;"
+        "crop_top:int:opt;"
+        "crop_right:int:opt;"
+        "crop_bottom:int:opt;"
+        "outputs:data[]:opt;"
+        "metadata:data:opt;"
+        "threads:int:opt;"
+        "frame_metrics:int:opt;"
+        "motion_skip:float:opt;",
         "clip:vnode;",
         Create4fscSource,
         nullptr,
         plugin
     );
+
+    vspapi->registerFunction(
+        "write_corrected_tbc",
+        "source:data;"
+        "output:data;"
+        "extra_sources:data[]:opt;"
+        "dropout_overcorrect:int:opt;"
+        "dropout_intra:int:opt;"
+        "dropout_detect:int:opt;"
+        "threads:int:opt;",
+        "frames_rewritten:int;"
+        "dropouts_corrected:int;"
+        "dropouts_failed:int;",
+        WriteCorrectedTbc,
+        nullptr,
+        plugin
+    );
+
+    vspapi->registerFunction(
+        "thumbnails",
+        "source:data;"
+        "interval:int:opt;"
+        "width:int:opt;"
+        "threads:int:opt;"
+        "cache:int:opt;"
+        "metadata:data:opt;",
+        "clip:vnode;",
+        CreateThumbnails,
+        nullptr,
+        plugin
+    );
+
+    vspapi->registerFunction(
+        "clear_source_cache",
+        "",
+        "",
+        ClearSourceCache,
+        nullptr,
+        plugin
+    );
 }
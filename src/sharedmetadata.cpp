@@ -0,0 +1,166 @@
+/******************************************************************************
+ * sharedmetadata.cpp
+ * vapoursynth-analog - Metadata sidecars shared by every reader of them
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "sharedmetadata.h"
+#include "dropoutdetector.h"
+#include "sqlite3_metadata_reader.h"
+#include "vbidecoder.h"
+
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::mutex registryMutex;
+std::map<std::string, std::weak_ptr<SharedMetadata>> registry;
+
+// Canonical path, size and modification time of a DB, so that a sidecar
+// rewritten (e.g. reconverted from JSON) since it was read isn't reused
+std::string identityKey(const QString &dbPath) {
+    const std::filesystem::path path = dbPath.toStdString();
+    std::error_code ec;
+    std::ostringstream key;
+    const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    key << (ec ? path : canonical).string() << '|';
+    const auto size = std::filesystem::file_size(path, ec);
+    key << (ec ? 0 : size) << '|';
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    key << (ec ? 0 : mtime.time_since_epoch().count());
+    return key.str();
+}
+
+// Scan all frames to determine the VBI frame range.
+// Adapted from CorrectorPool::setMinAndMaxVbiFrames().
+SharedMetadata::VbiFrameRange scanVbiFrameRange(LdDecodeMetaData &meta) {
+    VbiDecoder vbiDecoder;
+    qint32 cavCount = 0, clvCount = 0;
+    qint32 cavMin = 1000000, cavMax = 0;
+    qint32 clvMin = 1000000, clvMax = 0;
+
+    for (qint32 seqFrame = 1; seqFrame <= meta.getNumberOfFrames(); seqFrame++) {
+        auto vbi1 = meta.getFieldVbi(meta.getFirstFieldNumber(seqFrame)).vbiData;
+        auto vbi2 = meta.getFieldVbi(meta.getSecondFieldNumber(seqFrame)).vbiData;
+        VbiDecoder::Vbi vbi = vbiDecoder.decodeFrame(
+            vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
+
+        if (vbi.picNo > 0) {
+            cavCount++;
+            if (vbi.picNo < cavMin) cavMin = vbi.picNo;
+            if (vbi.picNo > cavMax) cavMax = vbi.picNo;
+        }
+
+        if (vbi.clvHr != -1 && vbi.clvMin != -1 &&
+            vbi.clvSec != -1 && vbi.clvPicNo != -1) {
+            clvCount++;
+            LdDecodeMetaData::ClvTimecode timecode;
+            timecode.hours = vbi.clvHr;
+            timecode.minutes = vbi.clvMin;
+            timecode.seconds = vbi.clvSec;
+            timecode.pictureNumber = vbi.clvPicNo;
+            qint32 cvFrame = meta.convertClvTimecodeToFrameNumber(timecode);
+            if (cvFrame < clvMin) clvMin = cvFrame;
+            if (cvFrame > clvMax) clvMax = cvFrame;
+        }
+    }
+
+    SharedMetadata::VbiFrameRange range;
+    if (cavCount == 0 && clvCount == 0) {
+        return range;
+    }
+
+    range.available = true;
+    if (cavCount > clvCount) {
+        range.discTypeCav = true;
+        range.minFrame = cavMin;
+        range.maxFrame = cavMax;
+    } else {
+        range.discTypeCav = false;
+        range.minFrame = clvMin;
+        range.maxFrame = clvMax;
+    }
+    return range;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<SharedMetadata> SharedMetadata::acquire(const QString &dbPath) {
+    const std::string key = identityKey(dbPath);
+
+    std::shared_ptr<SharedMetadata> shared;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto it = registry.begin(); it != registry.end();) {
+            it = it->second.expired() ? registry.erase(it) : std::next(it);
+        }
+        std::weak_ptr<SharedMetadata> &entry = registry[key];
+        shared = entry.lock();
+        if (!shared) {
+            shared = std::make_shared<SharedMetadata>();
+            entry = shared;
+        }
+    }
+
+    // Readers of one DB opened at once wait for the first to read it,
+    // without holding up readers of other DBs
+    std::lock_guard<std::mutex> lock(shared->loadMutex);
+    if (shared->loaded) {
+        return shared;
+    }
+
+    auto meta = std::make_unique<LdDecodeMetaData>();
+    if (!Sqlite3MetadataReader::read(dbPath, *meta)) {
+        return nullptr;
+    }
+    shared->meta = std::move(meta);
+    shared->dbPath = dbPath;
+    shared->loaded = true;
+    return shared;
+}
+
+SharedMetadata::SharedMetadata()
+    : meta(std::make_unique<LdDecodeMetaData>())
+{
+}
+
+const LdDecodeMetaData::VideoParameters &SharedMetadata::getVideoParameters() const {
+    return meta->getVideoParameters();
+}
+
+const LdDecodeMetaData::Field &SharedMetadata::getField(qint32 sequentialFieldNumber) const {
+    return meta->getField(sequentialFieldNumber);
+}
+
+qint32 SharedMetadata::getNumberOfFields() const {
+    return meta->getNumberOfFields();
+}
+
+qint32 SharedMetadata::getNumberOfFrames() const {
+    return meta->getNumberOfFrames();
+}
+
+qint32 SharedMetadata::getFirstFieldNumber(qint32 frameNumber) const {
+    return meta->getFirstFieldNumber(frameNumber);
+}
+
+qint32 SharedMetadata::getSecondFieldNumber(qint32 frameNumber) const {
+    return meta->getSecondFieldNumber(frameNumber);
+}
+
+const SharedMetadata::VbiFrameRange &SharedMetadata::vbiFrameRange() const {
+    std::call_once(vbiScanned, [this] { vbiRange = scanVbiFrameRange(*meta); });
+    return vbiRange;
+}
+
+bool SharedMetadata::listsDropouts() const {
+    std::call_once(dropoutsChecked, [this] {
+        hasListedDropouts = DropoutDetector::metadataListsDropouts(*meta);
+    });
+    return hasListedDropouts;
+}
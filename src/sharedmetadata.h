@@ -0,0 +1,75 @@
+/******************************************************************************
+ * sharedmetadata.h
+ * vapoursynth-analog - Metadata sidecars shared by every reader of them
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef SHAREDMETADATA_H
+#define SHAREDMETADATA_H
+
+#include <memory>
+#include <mutex>
+
+#include <QString>
+
+#include "lddecodemetadata.h"
+
+// One metadata DB as read by Sqlite3MetadataReader, with the indexes derived
+// from it. Readers of the same sidecar (the luma and chroma TBCs of a Y/C
+// capture, or a source and a thumbnail index) share a single instance rather
+// than each reading the DB again. Entries are keyed by the DB's canonical
+// path, size and modification time, and live as long as any reader holds
+// them, so a rewritten sidecar is read afresh.
+//
+// The metadata is read once, under loadMutex, and never modified after, so
+// holders read it from any thread without locking. LdDecodeMetaData's getters
+// aren't declared const but only look up what was read; only the const
+// getters here reach them. The VBI and dropout indexes are derived on first
+// use.
+class SharedMetadata {
+public:
+    // Metadata of the DB at dbPath, read unless a live instance already has
+    // it. Returns nullptr if the DB can't be read.
+    static std::shared_ptr<SharedMetadata> acquire(const QString &dbPath);
+
+    // Empty metadata, as held by readers before they open a TBC
+    SharedMetadata();
+
+    // Path of the DB read (empty for empty metadata)
+    const QString &getDbPath() const { return dbPath; }
+
+    // The metadata's contents (fields and frames numbered from 1)
+    const LdDecodeMetaData::VideoParameters &getVideoParameters() const;
+    const LdDecodeMetaData::Field &getField(qint32 sequentialFieldNumber) const;
+    qint32 getNumberOfFields() const;
+    qint32 getNumberOfFrames() const;
+    qint32 getFirstFieldNumber(qint32 frameNumber) const;
+    qint32 getSecondFieldNumber(qint32 frameNumber) const;
+
+    // Range of VBI frame numbers, scanned on first use
+    struct VbiFrameRange {
+        bool available = false;  // False if no frame carries a VBI frame number
+        bool discTypeCav = false;
+        qint32 minFrame = 0;
+        qint32 maxFrame = 0;
+    };
+    const VbiFrameRange &vbiFrameRange() const;
+
+    // Whether any field lists dropouts, checked on first use
+    bool listsDropouts() const;
+
+private:
+    std::mutex loadMutex;  // Held while the DB is read
+    std::unique_ptr<LdDecodeMetaData> meta;
+    QString dbPath;
+    bool loaded = false;
+
+    mutable std::once_flag vbiScanned;
+    mutable VbiFrameRange vbiRange;
+
+    mutable std::once_flag dropoutsChecked;
+    mutable bool hasListedDropouts = false;
+};
+
+#endif // SHAREDMETADATA_H
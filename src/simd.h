@@ -0,0 +1,23 @@
+/******************************************************************************
+ * simd.h
+ * vapoursynth-analog - Vector instruction set of the build target
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef SIMD_H
+#define SIMD_H
+
+// Every x86-64 target has SSE2 (as do 32-bit x86 targets built for it) and
+// every ARM64 target has NEON, so kernels written for these need no runtime
+// dispatch: they use whichever one is defined here, and otherwise fall back
+// to the scalar version they keep as a reference for their tests.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VSANALOG_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define VSANALOG_NEON 1
+#include <arm_neon.h>
+#endif
+
+#endif // SIMD_H
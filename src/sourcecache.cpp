@@ -0,0 +1,173 @@
+/******************************************************************************
+ * sourcecache.cpp
+ * vapoursynth-analog - Process-lifetime cache of opened 4𝑓𝑠𝑐 sources
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "sourcecache.h"
+#include "analog4fsc.h"
+
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Number of sources kept alive after their last clip is freed. A script
+// typically opens one or two sources; a few spare slots cover switching
+// between a handful of captures or option variants while editing.
+constexpr size_t MAX_CACHED_SOURCES = 4;
+
+struct CacheEntry {
+    std::string key;
+    std::vector<std::filesystem::path> sidecars;  // Metadata DBs the source read
+    std::string sidecarIdentity;
+    std::shared_ptr<VSAnalog4fscSource> source;
+};
+
+std::mutex cacheMutex;
+std::list<CacheEntry> cacheEntries;  // Most recently used first
+
+// Append the identity of a file (canonical path, size and modification
+// time) to the key
+void appendFileIdentity(std::ostringstream &key, const std::filesystem::path &path) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    key << (ec ? path : canonical).string() << '|';
+
+    if (!std::filesystem::exists(path, ec)) {
+        key << "missing;";
+        return;
+    }
+    const auto size = std::filesystem::file_size(path, ec);
+    key << (ec ? 0 : size) << '|';
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    key << (ec ? 0 : mtime.time_since_epoch().count()) << ';';
+}
+
+// Identity of the sidecars a source was opened from. Which sidecar a TBC
+// uses (its own .db, one converted from JSON, or the luma's) is only known
+// once it is open, so entries are checked against this rather than keyed on
+// every candidate: a JSON sidecar converted on the first open then still
+// matches on the next.
+std::string sidecarIdentity(const std::vector<std::filesystem::path> &sidecars) {
+    std::ostringstream identity;
+    for (const auto &path : sidecars) {
+        appendFileIdentity(identity, path);
+    }
+    return identity.str();
+}
+
+std::string makeKey(const std::filesystem::path &sourcePath,
+                    const std::filesystem::path *chromaSourcePath,
+                    const std::filesystem::path *prSourcePath,
+                    const VSAnalog4fscOptions &opts) {
+    std::ostringstream key;
+    key.precision(17);
+
+    key << "src:";
+    appendFileIdentity(key, sourcePath);
+    key << "chroma:";
+    if (chromaSourcePath) {
+        appendFileIdentity(key, *chromaSourcePath);
+    }
+    key << "pr:";
+    if (prSourcePath) {
+        appendFileIdentity(key, *prSourcePath);
+    }
+    // An explicit JSON sidecar is converted again on every open
+    key << "meta:";
+    if (!opts.metadataPath.empty()) {
+        appendFileIdentity(key, opts.metadataPath);
+    }
+    key << "extraLuma:";
+    for (const auto &extraPath : opts.dropoutExtraLumaSources) {
+        appendFileIdentity(key, extraPath);
+    }
+    key << "extraChroma:";
+    for (const auto &extraPath : opts.dropoutExtraChromaSources) {
+        appendFileIdentity(key, extraPath);
+    }
+    key << "opts:"
+        << opts.chromaGain << ',' << opts.chromaPhase << ','
+        << opts.chromaNR << ',' << opts.lumaNR << ','
+        << opts.paddingMultiple << ','
+        << opts.reverseFields << ',' << opts.phaseCompensation << ','
+        << opts.dropoutCorrect << ',' << opts.dropoutOvercorrect << ','
+        << opts.dropoutIntra << ',' << opts.correctedFrameCacheSize << ','
+        << opts.dropoutDetect << ','
+        << opts.ivtcVbi << ',' << opts.fieldOutput << ','
+        << static_cast<int>(opts.outputFormat) << ',' << opts.matrixBT709 << ','
+        << opts.cropLeft << ',' << opts.cropTop << ','
+        << opts.cropRight << ',' << opts.cropBottom << ','
+        << opts.decodeThreads << ',' << opts.motionSkip << ','
+        << opts.decoder;
+
+    return key.str();
+}
+
+// The live entry for key, moved to the front, or null. Entries whose
+// sidecars changed since they were opened are moved into stale.
+std::shared_ptr<VSAnalog4fscSource> findEntry(const std::string &key,
+                                              std::list<CacheEntry> &stale) {
+    for (auto it = cacheEntries.begin(); it != cacheEntries.end(); ++it) {
+        if (it->key != key) continue;
+        if (sidecarIdentity(it->sidecars) != it->sidecarIdentity) {
+            stale.splice(stale.end(), cacheEntries, it);
+            return nullptr;
+        }
+        cacheEntries.splice(cacheEntries.begin(), cacheEntries, it);
+        return cacheEntries.front().source;
+    }
+    return nullptr;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<VSAnalog4fscSource> VSAnalogSourceCache::acquire(
+    const std::filesystem::path &sourcePath,
+    const std::filesystem::path *chromaSourcePath,
+    const std::filesystem::path *prSourcePath,
+    const VSAnalog4fscOptions &opts) {
+    const std::string key = makeKey(sourcePath, chromaSourcePath, prSourcePath, opts);
+
+    // Dropped entries are destroyed outside the lock, on return
+    std::list<CacheEntry> dropped;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (auto cached = findEntry(key, dropped)) {
+            return cached;
+        }
+    }
+
+    // Open outside the lock: opening can take seconds (JSON conversion, VBI
+    // scans) and other sources shouldn't wait on it.
+    auto source = std::make_shared<VSAnalog4fscSource>(
+        sourcePath, chromaSourcePath, prSourcePath, &opts);
+    std::vector<std::filesystem::path> sidecars = source->GetMetadataPaths();
+    std::string identity = sidecarIdentity(sidecars);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (auto cached = findEntry(key, dropped)) {
+        // Another thread opened the same inputs meanwhile; share theirs
+        return cached;
+    }
+    cacheEntries.push_front({key, std::move(sidecars), std::move(identity), source});
+    while (cacheEntries.size() > MAX_CACHED_SOURCES) {
+        dropped.splice(dropped.end(), cacheEntries, std::prev(cacheEntries.end()));
+    }
+    return source;
+}
+
+void VSAnalogSourceCache::clear() {
+    std::list<CacheEntry> dropped;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        dropped.swap(cacheEntries);
+    }
+    // Sources are destroyed here, outside the lock
+}
@@ -0,0 +1,41 @@
+/******************************************************************************
+ * sourcecache.h
+ * vapoursynth-analog - Process-lifetime cache of opened 4𝑓𝑠𝑐 sources
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef SOURCECACHE_H
+#define SOURCECACHE_H
+
+#include <filesystem>
+#include <memory>
+
+class VSAnalog4fscSource;
+struct VSAnalog4fscOptions;
+
+// Keeps recently opened sources alive for the life of the process so that
+// re-evaluating a script (e.g. vspreview reloading on every edit) reuses the
+// parsed metadata, VBI scans, configured decoders and recently corrected
+// fields instead of opening everything again.
+//
+// Entries are keyed by the identity (path, size and modification time) of
+// every TBC involved plus all decode options, and checked against the
+// identity of the metadata sidecars the source was opened from, so
+// rewriting a capture or changing an option opens a fresh source.
+class VSAnalogSourceCache {
+public:
+    // Return the cached source for these inputs, opening and caching a new
+    // one if there is none. Throws VSAnalogException if opening fails.
+    static std::shared_ptr<VSAnalog4fscSource> acquire(
+        const std::filesystem::path &sourcePath,
+        const std::filesystem::path *chromaSourcePath,
+        const std::filesystem::path *prSourcePath,
+        const VSAnalog4fscOptions &opts);
+
+    // Drop all cached sources. Sources still used by live clips stay open
+    // until those clips are freed.
+    static void clear();
+};
+
+#endif // SOURCECACHE_H
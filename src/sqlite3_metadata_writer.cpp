@@ -0,0 +1,126 @@
+/******************************************************************************
+ * sqlite3_metadata_writer.cpp
+ * vapoursynth-analog - SQLite3-based TBC metadata updates (no Qt SQL)
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "sqlite3_metadata_writer.h"
+
+#include <sqlite3.h>
+#include <QDebug>
+
+namespace {
+
+bool execSql(sqlite3 *db, const char *sql, const char *errorContext) {
+    char *errMsg = nullptr;
+    int rc = sqlite3_exec(db, sql, nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK) {
+        qCritical() << errorContext << ":" << errMsg;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// Run a prepared single-row statement, returning false (after logging) on error
+bool stepStatement(sqlite3 *db, sqlite3_stmt *stmt, const char *errorContext) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE) {
+        qCritical() << errorContext << ":" << sqlite3_errmsg(db);
+        return false;
+    }
+    return true;
+}
+
+bool writeDropOuts(sqlite3 *db, const QVector<qint32> &seqNos,
+                   const QVector<DropoutSpan> &spans) {
+    // Schema matches ld-decode's drop_outs table
+    const char *createDropOuts = R"(
+        CREATE TABLE IF NOT EXISTS drop_outs (
+            capture_id INTEGER NOT NULL REFERENCES capture(capture_id) ON DELETE CASCADE,
+            field_id INTEGER NOT NULL,
+            field_line INTEGER NOT NULL,
+            startx INTEGER NOT NULL,
+            endx INTEGER NOT NULL,
+            PRIMARY KEY (capture_id, field_id, field_line, startx, endx),
+            FOREIGN KEY (capture_id, field_id) REFERENCES field_record(capture_id, field_id) ON DELETE CASCADE
+        );
+    )";
+    if (!execSql(db, createDropOuts, "Failed to create drop_outs table")) {
+        return false;
+    }
+
+    sqlite3_stmt *deleteStmt = nullptr;
+    sqlite3_stmt *insertStmt = nullptr;
+    const char *deleteSql = "DELETE FROM drop_outs WHERE capture_id = 1 AND field_id = ?;";
+    const char *insertSql = R"(
+        INSERT OR IGNORE INTO drop_outs (capture_id, field_id, field_line, startx, endx)
+        VALUES (1, ?, ?, ?, ?);
+    )";
+
+    if (sqlite3_prepare_v2(db, deleteSql, -1, &deleteStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, insertSql, -1, &insertStmt, nullptr) != SQLITE_OK) {
+        qCritical() << "Failed to prepare dropout statements:" << sqlite3_errmsg(db);
+        sqlite3_finalize(deleteStmt);
+        sqlite3_finalize(insertStmt);
+        return false;
+    }
+
+    bool ok = true;
+
+    // field_id is 0-indexed, seqNo is 1-indexed
+    for (qint32 seqNo : seqNos) {
+        sqlite3_bind_int(deleteStmt, 1, seqNo - 1);
+        if (!stepStatement(db, deleteStmt, "Failed to delete dropouts")) {
+            ok = false;
+            break;
+        }
+    }
+
+    for (qint32 i = 0; ok && i < spans.size(); i++) {
+        sqlite3_bind_int(insertStmt, 1, spans[i].seqNo - 1);
+        sqlite3_bind_int(insertStmt, 2, spans[i].fieldLine);
+        sqlite3_bind_int(insertStmt, 3, spans[i].startx);
+        sqlite3_bind_int(insertStmt, 4, spans[i].endx);
+        ok = stepStatement(db, insertStmt, "Failed to insert dropout");
+    }
+
+    sqlite3_finalize(deleteStmt);
+    sqlite3_finalize(insertStmt);
+    return ok;
+}
+
+} // anonymous namespace
+
+bool Sqlite3MetadataWriter::replaceDropOuts(const QString &dbPath,
+                                            const QVector<qint32> &seqNos,
+                                            const QVector<DropoutSpan> &spans) {
+    sqlite3 *db = nullptr;
+    int rc = sqlite3_open_v2(dbPath.toUtf8().constData(), &db, SQLITE_OPEN_READWRITE, nullptr);
+    if (rc != SQLITE_OK) {
+        qCritical() << "Failed to open database:" << dbPath << "-" << sqlite3_errmsg(db);
+        sqlite3_close(db);
+        return false;
+    }
+
+    if (!execSql(db, "BEGIN TRANSACTION;", "Failed to begin transaction")) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    if (!writeDropOuts(db, seqNos, spans)) {
+        execSql(db, "ROLLBACK;", "Rollback failed");
+        sqlite3_close(db);
+        return false;
+    }
+
+    if (!execSql(db, "COMMIT;", "Failed to commit transaction")) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    sqlite3_close(db);
+    return true;
+}
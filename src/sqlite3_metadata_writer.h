@@ -0,0 +1,27 @@
+/******************************************************************************
+ * sqlite3_metadata_writer.h
+ * vapoursynth-analog - SQLite3-based TBC metadata updates (no Qt SQL)
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef SQLITE3_METADATA_WRITER_H
+#define SQLITE3_METADATA_WRITER_H
+
+#include <QString>
+#include <QVector>
+#include "dropoutcorrector.h"
+
+// Update TBC metadata in an existing SQLite database using sqlite3 C API
+// This avoids Qt SQL to prevent symbol conflicts with PyQt
+class Sqlite3MetadataWriter {
+public:
+    // Replace the dropout records of the given fields (1-based sequence
+    // numbers) with the supplied spans, creating the drop_outs table if the
+    // database lacks one. Returns true on success, false on failure
+    static bool replaceDropOuts(const QString &dbPath,
+                                const QVector<qint32> &seqNos,
+                                const QVector<DropoutSpan> &spans);
+};
+
+#endif // SQLITE3_METADATA_WRITER_H
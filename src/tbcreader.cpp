@@ -6,13 +6,138 @@
  ******************************************************************************/
 
 #include "tbcreader.h"
+#include "dropoutdetector.h"
 #include "jsonconverter_wrapper.h"
-#include "sqlite3_metadata_reader.h"
+#include "pipefieldsource.h"
 #include "vbidecoder.h"
 
 #include <QFileInfo>
 #include <QDebug>
 
+#include <algorithm>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+
+namespace {
+
+// Pipe input keeps this many frames beyond the decode window for requests
+// arriving slightly out of order from parallel consumers, and reads up to
+// this many frames ahead of the newest request while earlier ones decode
+constexpr qint32 PIPE_REORDER_FRAMES = 8;
+constexpr qint32 PIPE_PREFETCH_FRAMES = 8;
+
+// Decoder setup plans FFTs (Transform PAL), and FFTW's planner isn't
+// thread-safe; decode contexts may be configured from frame threads
+std::mutex decoderSetupMutex;
+
+// SQLite sidecars being written from JSON. Sources opened at once (e.g. by
+// decode_many, or TBCs sharing a sidecar) wait for a conversion to the same
+// DB in progress and use its result instead of writing the DB concurrently.
+std::mutex conversionMutex;
+std::condition_variable conversionDone;
+std::set<QString> conversionsInProgress;
+
+bool convertJsonMetadata(const QString &jsonPath, const QString &dbPath) {
+    std::unique_lock<std::mutex> lock(conversionMutex);
+    if (conversionsInProgress.count(dbPath)) {
+        conversionDone.wait(lock, [&]() { return !conversionsInProgress.count(dbPath); });
+        return QFileInfo::exists(dbPath);
+    }
+    conversionsInProgress.insert(dbPath);
+    lock.unlock();
+
+    const bool converted = convertJsonToSqlite(jsonPath, dbPath);
+
+    lock.lock();
+    conversionsInProgress.erase(dbPath);
+    lock.unlock();
+    conversionDone.notify_all();
+    return converted;
+}
+
+// Device holding a file, so that extra sources sharing a disk are read by
+// one task instead of competing for it. -1 if unknown.
+qint64 fileDeviceId(const std::filesystem::path &path) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_wstat64(path.c_str(), &st) != 0) return -1;
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return -1;
+#endif
+    return static_cast<qint64>(st.st_dev);
+}
+
+// CAV picture number decoded from the VBI of a frame's two fields, or of a
+// single field when second is null. Returns -1 if there is none.
+qint32 vbiPictureNumber(VbiDecoder &vbiDecoder, const LdDecodeMetaData::Vbi &first,
+                        const LdDecodeMetaData::Vbi *second = nullptr) {
+    const auto &vbi1 = first.vbiData;
+    VbiDecoder::Vbi vbi;
+    if (second) {
+        const auto &vbi2 = second->vbiData;
+        vbi = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
+    } else {
+        vbi = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], 0, 0, 0);
+    }
+    return vbi.picNo > 0 ? vbi.picNo : -1;
+}
+
+// Rows of motion blocks are split into at most this many bands for
+// motionSkip, each decoded in 2D or 3D on its own
+constexpr int MOTION_BANDS = 4;
+
+// Transform PAL lays overlapping tiles over its active area from the
+// area's origin, in steps of half a tile: 16 samples or fewer, and 8 or 16
+// field lines
+constexpr int TRANSFORM_TILE_STEP_SAMPLES = 16;
+constexpr int TRANSFORM_TILE_STEP_FRAME_LINES = 32;
+
+bool isTransformDecoder(TbcReader::DecoderType decoder) {
+    return decoder == TbcReader::DecoderType::Transform2D
+        || decoder == TbcReader::DecoderType::Transform3D;
+}
+
+// The decoders only process their configured active area, and their
+// filters read decoded neighbours: video parameters narrowed to the samples
+// [startSample, endSample) and frame lines [firstLine, endLine) keep a
+// margin around that area, so the samples in it are decoded as they are
+// from bounds (whose active area limits the margins). Margins cover the
+// comb/PALcolour filter reach. Edges stay aligned to 4 samples and 4 frame
+// lines from the bounds' active area, so subcarrier phase and field/line
+// phase are unchanged; with transformTiles, to the Transform PAL tile
+// steps, so the tiles covering the area are the ones laid over bounds.
+LdDecodeMetaData::VideoParameters narrowedDecoderArea(
+        const LdDecodeMetaData::VideoParameters &bounds, int startSample, int endSample,
+        int firstLine, int endLine, bool transformTiles) {
+    static constexpr int MARGIN_SAMPLES = 32;
+    static constexpr int MARGIN_LINES = 8;
+    const int sampleStep = transformTiles ? TRANSFORM_TILE_STEP_SAMPLES : 4;
+    const int lineStep = transformTiles ? TRANSFORM_TILE_STEP_FRAME_LINES : 4;
+    auto alignDown = [](int value, int origin, int step) {
+        return origin + ((value - origin) / step) * step;
+    };
+    auto alignUp = [](int value, int origin, int step) {
+        return origin + ((value - origin + step - 1) / step) * step;
+    };
+
+    LdDecodeMetaData::VideoParameters narrowed = bounds;
+    narrowed.activeVideoStart = std::max(bounds.activeVideoStart,
+        alignDown(startSample - MARGIN_SAMPLES, bounds.activeVideoStart, sampleStep));
+    narrowed.activeVideoEnd = std::min(bounds.activeVideoEnd,
+        alignUp(endSample + MARGIN_SAMPLES, bounds.activeVideoStart, sampleStep));
+    narrowed.firstActiveFrameLine = std::max(bounds.firstActiveFrameLine,
+        alignDown(firstLine - MARGIN_LINES, bounds.firstActiveFrameLine, lineStep));
+    narrowed.lastActiveFrameLine = std::min(bounds.lastActiveFrameLine,
+        alignUp(endLine + MARGIN_LINES, bounds.firstActiveFrameLine, lineStep));
+    return narrowed;
+}
+
+} // anonymous namespace
+
 TbcReader::DecoderType TbcReader::parseDecoderName(const QString &name) {
     QString lower = name.toLower();
     if (lower == "ntsc1d") return DecoderType::Ntsc1D;
@@ -26,9 +151,16 @@ TbcReader::DecoderType TbcReader::parseDecoderName(const QString &name) {
     return DecoderType::Auto;
 }
 
+TbcReader::SourceState::SourceState()
+    : sourceVideo(std::make_unique<SourceVideo>())
+{
+}
+
+TbcReader::SourceState::~SourceState() = default;
+
 TbcReader::TbcReader()
-    : metadata(std::make_unique<LdDecodeMetaData>())
-    , sourceVideo(std::make_unique<SourceVideo>())
+    : metadata(std::make_shared<SharedMetadata>())
+    , source(std::make_shared<SourceState>())
 {
 }
 
@@ -37,61 +169,94 @@ TbcReader::~TbcReader() {
 }
 
 bool TbcReader::openTbcSource(const QString &tbcPathStr,
-                              LdDecodeMetaData &meta, SourceVideo &video,
+                              std::shared_ptr<SharedMetadata> &meta, SourceVideo &video,
                               const QString &fallbackMetadataDbPath) {
-    // Find metadata file (.db or .json, converting JSON to SQLite if needed)
-    QFileInfo tbcInfo(tbcPathStr);
-    QString baseName = tbcInfo.absolutePath() + "/" + tbcInfo.completeBaseName();
-    QString dbPath = baseName + ".db";
+    if (!readTbcMetadata(tbcPathStr, meta, fallbackMetadataDbPath)) {
+        return false;
+    }
 
-    if (!QFileInfo::exists(dbPath)) {
-        dbPath = tbcPathStr + ".db";
+    auto vp = meta->getVideoParameters();
+    qint32 fieldLength = vp.fieldWidth * vp.fieldHeight;
+    if (!video.open(tbcPathStr, fieldLength, vp.fieldWidth)) {
+        lastError = "Failed to open TBC file: " + tbcPathStr;
+        return false;
     }
 
-    if (!QFileInfo::exists(dbPath)) {
-        QString jsonPath = baseName + ".json";
-        if (!QFileInfo::exists(jsonPath)) jsonPath = tbcPathStr + ".json";
-        if (!QFileInfo::exists(jsonPath)) jsonPath = baseName + ".tbc.json";
+    return true;
+}
 
-        if (QFileInfo::exists(jsonPath)) {
-            qInfo() << "Found JSON metadata, converting to SQLite:" << jsonPath;
-            if (!convertJsonToSqlite(jsonPath, dbPath)) {
-                lastError = "Failed to convert JSON metadata to SQLite: " + jsonPath;
+bool TbcReader::readTbcMetadata(const QString &tbcPathStr, std::shared_ptr<SharedMetadata> &meta,
+                                const QString &fallbackMetadataDbPath,
+                                const QString &explicitMetadataPath) {
+    QString dbPath;
+    if (!explicitMetadataPath.isEmpty()) {
+        if (!QFileInfo::exists(explicitMetadataPath)) {
+            lastError = "Metadata file not found: " + explicitMetadataPath;
+            return false;
+        }
+        dbPath = explicitMetadataPath;
+        if (explicitMetadataPath.endsWith(".json", Qt::CaseInsensitive)) {
+            // Convert next to the JSON, as for sidecars found by the TBC name
+            QFileInfo jsonInfo(explicitMetadataPath);
+            QString baseName = jsonInfo.absolutePath() + "/" + jsonInfo.completeBaseName();
+            if (baseName.endsWith(".tbc")) baseName.chop(4);
+            dbPath = baseName + ".db";
+            qInfo() << "Converting JSON metadata to SQLite:" << explicitMetadataPath;
+            if (!convertJsonMetadata(explicitMetadataPath, dbPath)) {
+                lastError = "Failed to convert JSON metadata to SQLite: " + explicitMetadataPath;
                 return false;
             }
-        } else if (!fallbackMetadataDbPath.isEmpty() &&
-                   QFileInfo::exists(fallbackMetadataDbPath)) {
-            // No sidecar of its own: reuse the supplied (luma) metadata. For
-            // Y/C-separated VHS, vhs-decode emits one shared sidecar and the
-            // chroma TBC has the same field geometry as the luma TBC.
-            qInfo() << "No metadata sidecar for" << tbcPathStr
-                    << "- using fallback metadata:" << fallbackMetadataDbPath;
-            dbPath = fallbackMetadataDbPath;
-        } else {
-            lastError = "Could not find metadata file (.db or .json): " + baseName;
-            return false;
         }
-    }
+    } else {
+        // Find metadata file (.db or .json, converting JSON to SQLite if needed)
+        QFileInfo tbcInfo(tbcPathStr);
+        QString baseName = tbcInfo.absolutePath() + "/" + tbcInfo.completeBaseName();
+        dbPath = baseName + ".db";
 
-    metadataDbPath = dbPath;
+        if (!QFileInfo::exists(dbPath)) {
+            dbPath = tbcPathStr + ".db";
+        }
 
-    if (!Sqlite3MetadataReader::read(dbPath, meta)) {
+        if (!QFileInfo::exists(dbPath)) {
+            QString jsonPath = baseName + ".json";
+            if (!QFileInfo::exists(jsonPath)) jsonPath = tbcPathStr + ".json";
+            if (!QFileInfo::exists(jsonPath)) jsonPath = baseName + ".tbc.json";
+
+            if (QFileInfo::exists(jsonPath)) {
+                qInfo() << "Found JSON metadata, converting to SQLite:" << jsonPath;
+                if (!convertJsonMetadata(jsonPath, dbPath)) {
+                    lastError = "Failed to convert JSON metadata to SQLite: " + jsonPath;
+                    return false;
+                }
+            } else if (!fallbackMetadataDbPath.isEmpty() &&
+                       QFileInfo::exists(fallbackMetadataDbPath)) {
+                // No sidecar of its own: reuse the supplied (luma) metadata. For
+                // Y/C-separated VHS, vhs-decode emits one shared sidecar and the
+                // chroma TBC has the same field geometry as the luma TBC.
+                qInfo() << "No metadata sidecar for" << tbcPathStr
+                        << "- using fallback metadata:" << fallbackMetadataDbPath;
+                dbPath = fallbackMetadataDbPath;
+            } else {
+                lastError = "Could not find metadata file (.db or .json): " + baseName;
+                return false;
+            }
+        }
+    }
+
+    // A Y/C capture's chroma TBC, and extra sources sharing a sidecar, reuse
+    // what the luma reader has already read
+    meta = SharedMetadata::acquire(dbPath);
+    if (!meta) {
         lastError = "Failed to read metadata from: " + dbPath;
         return false;
     }
 
-    auto vp = meta.getVideoParameters();
+    auto vp = meta->getVideoParameters();
     if (!vp.isValid) {
         lastError = "Invalid video parameters in metadata";
         return false;
     }
 
-    qint32 fieldLength = vp.fieldWidth * vp.fieldHeight;
-    if (!video.open(tbcPathStr, fieldLength, vp.fieldWidth)) {
-        lastError = "Failed to open TBC file: " + tbcPathStr;
-        return false;
-    }
-
     return true;
 }
 
@@ -101,20 +266,70 @@ bool TbcReader::open(const std::filesystem::path &tbcPath, const Configuration &
     config = cfg;
 
     QString tbcPathStr = QString::fromStdString(tbcPath.string());
-    if (!openTbcSource(tbcPathStr, *metadata, *sourceVideo, fallbackMetadataDbPath)) {
+    this->tbcPath = tbcPathStr;
+    const QString explicitMetadataPath = QString::fromStdString(config.metadataPath.string());
+    const bool pipeInput = isPipeInput(tbcPath);
+    std::shared_ptr<SharedMetadata> sharedMetadata;
+    if (pipeInput || !explicitMetadataPath.isEmpty()) {
+        // Standard input has no name to find a sidecar by, so its metadata
+        // must be given or come from the fallback
+        if (!readTbcMetadata(tbcPathStr, sharedMetadata, fallbackMetadataDbPath, explicitMetadataPath)) {
+            return false;
+        }
+        const auto vp = sharedMetadata->getVideoParameters();
+        if (!pipeInput &&
+            !source->sourceVideo->open(tbcPathStr, vp.fieldWidth * vp.fieldHeight, vp.fieldWidth)) {
+            lastError = "Failed to open TBC file: " + tbcPathStr;
+            return false;
+        }
+    } else if (!openTbcSource(tbcPathStr, sharedMetadata, *source->sourceVideo, fallbackMetadataDbPath)) {
         return false;
     }
+    metadata = sharedMetadata;
+    metadataDbPath = metadata->getDbPath();
 
     videoParameters = metadata->getVideoParameters();
 
+    // Calculate output dimensions (cropped active video area only)
+    if (!applyCrop()) {
+        return false;
+    }
+
     // Configure the appropriate decoder
     if (!configureDecoder()) {
         return false;
     }
 
-    // Calculate output dimensions (active video area only)
-    activeWidth = videoParameters.activeVideoEnd - videoParameters.activeVideoStart;
-    activeHeight = videoParameters.lastActiveFrameLine - videoParameters.firstActiveFrameLine;
+    if (config.ivtcVbi) {
+        // The 3D decoders expect their neighbouring fields to continue the
+        // video field sequence (and its subcarrier phase), which neighbouring
+        // film frames don't
+        if (activeDecoder == DecoderType::Ntsc3D || activeDecoder == DecoderType::Ntsc3DNoAdapt
+            || activeDecoder == DecoderType::Transform3D) {
+            lastError = "VBI inverse telecine can't be combined with a 3D decoder";
+            return false;
+        }
+        if (!buildFilmFrameMap()) {
+            return false;
+        }
+    }
+
+    source->detectDropouts = shouldDetectDropouts(*metadata);
+
+    if (pipeInput) {
+        // Keep every field a decode window (of a frame up to
+        // PIPE_REORDER_FRAMES behind the newest request) can need
+        const qint32 windowFrames = lookBehind + 1 + lookAhead;
+        source->pipeSource = std::make_unique<PipeFieldSource>();
+        if (!source->pipeSource->open(tbcPath, videoParameters.fieldWidth * videoParameters.fieldHeight,
+                              2 * (windowFrames + PIPE_REORDER_FRAMES),
+                              2 * PIPE_PREFETCH_FRAMES)) {
+            lastError = source->pipeSource->getLastError();
+            source->pipeSource.reset();
+            return false;
+        }
+    }
+
     outputWidth = activeWidth;
     outputHeight = activeHeight;
 
@@ -130,7 +345,74 @@ bool TbcReader::open(const std::filesystem::path &tbcPath, const Configuration &
     return true;
 }
 
+std::unique_ptr<TbcReader> TbcReader::createDecodeContext() {
+    if (!isOpen) {
+        lastError = "TBC file not open";
+        return nullptr;
+    }
+    if (source->pipeSource) {
+        lastError = "Pipe input is read sequentially and can't be decoded in parallel";
+        return nullptr;
+    }
+
+    auto context = std::make_unique<TbcReader>();
+    context->metadata = metadata;
+    context->source = source;
+    context->tbcPath = tbcPath;
+    context->config = config;
+    context->metadataDbPath = metadataDbPath;
+    context->videoParameters = videoParameters;
+    context->decoderParameters = decoderParameters;
+    context->outputWidth = outputWidth;
+    context->outputHeight = outputHeight;
+    context->activeWidth = activeWidth;
+    context->activeHeight = activeHeight;
+    context->firstOutputLine = firstOutputLine;
+    context->outputVideoStart = outputVideoStart;
+
+    if (!context->configureDecoder()) {
+        lastError = context->lastError;
+        return nullptr;
+    }
+
+    context->isOpen = true;
+    return context;
+}
+
+bool TbcReader::applyCrop() {
+    const int fullWidth = videoParameters.activeVideoEnd - videoParameters.activeVideoStart;
+    const int fullHeight = videoParameters.lastActiveFrameLine - videoParameters.firstActiveFrameLine;
+
+    if (config.cropLeft < 0 || config.cropRight < 0 ||
+        config.cropTop < 0 || config.cropBottom < 0) {
+        lastError = "Crop values must not be negative";
+        return false;
+    }
+    if (config.cropLeft + config.cropRight >= fullWidth ||
+        config.cropTop + config.cropBottom >= fullHeight) {
+        lastError = QString("Crop leaves no picture (active area is %1x%2)")
+            .arg(fullWidth).arg(fullHeight);
+        return false;
+    }
+
+    outputVideoStart = videoParameters.activeVideoStart + config.cropLeft;
+    firstOutputLine = videoParameters.firstActiveFrameLine + config.cropTop;
+    activeWidth = fullWidth - config.cropLeft - config.cropRight;
+    activeHeight = fullHeight - config.cropTop - config.cropBottom;
+
+    // Kept samples are decoded exactly as without cropping. The decoder
+    // isn't configured yet; a Transform PAL decoder requested for NTSC only
+    // over-aligns.
+    decoderParameters = narrowedDecoderArea(videoParameters,
+                                            outputVideoStart, outputVideoStart + activeWidth,
+                                            firstOutputLine, firstOutputLine + activeHeight,
+                                            isTransformDecoder(config.decoder));
+    return true;
+}
+
 bool TbcReader::configureDecoder() {
+    std::lock_guard<std::mutex> lock(decoderSetupMutex);
+
     // Determine which decoder to use
     DecoderType decoder = config.decoder;
 
@@ -212,7 +494,21 @@ bool TbcReader::configureDecoder() {
                     break;
             }
 
-            combFilter->updateConfiguration(videoParameters, combConfig);
+            combFilter->updateConfiguration(decoderParameters, combConfig);
+            // ntsc3dnoadapt never falls back to 2D itself, so its moving
+            // areas aren't skipped
+            if (config.motionSkip > 0.0 && decoder == DecoderType::Ntsc3D) {
+                Comb::Configuration fallbackConfig = combConfig;
+                fallbackConfig.dimensions = 2;
+                fallbackConfig.adaptive = false;
+                fallbackCombFilter = std::make_unique<Comb>();
+                fallbackCombFilter->updateConfiguration(decoderParameters, fallbackConfig);
+                configureMotionBands();
+                for (MotionBand &band : motionBands) {
+                    band.combFilter = std::make_unique<Comb>();
+                    band.combFilter->updateConfiguration(band.parameters, fallbackConfig);
+                }
+            }
             lookBehind = combConfig.getLookBehind();
             lookAhead = combConfig.getLookAhead();
             qInfo() << "Using NTSC decoder:" << static_cast<int>(decoder)
@@ -247,7 +543,18 @@ bool TbcReader::configureDecoder() {
                     break;
             }
 
-            palColour->updateConfiguration(videoParameters, palConfig);
+            palColour->updateConfiguration(decoderParameters, palConfig);
+            if (config.motionSkip > 0.0 && decoder == DecoderType::Transform3D) {
+                PalColour::Configuration fallbackConfig = palConfig;
+                fallbackConfig.chromaFilter = PalColour::transform2DFilter;
+                fallbackPalColour = std::make_unique<PalColour>();
+                fallbackPalColour->updateConfiguration(decoderParameters, fallbackConfig);
+                configureMotionBands();
+                for (MotionBand &band : motionBands) {
+                    band.palColour = std::make_unique<PalColour>();
+                    band.palColour->updateConfiguration(band.parameters, fallbackConfig);
+                }
+            }
             lookBehind = palConfig.getLookBehind();
             lookAhead = palConfig.getLookAhead();
             qInfo() << "Using PAL decoder:" << static_cast<int>(decoder)
@@ -259,9 +566,9 @@ bool TbcReader::configureDecoder() {
         case DecoderType::Mono: {
             monoDecoder = std::make_unique<MonoDecoder>();
             MonoDecoder::MonoConfiguration monoConfig;
-            monoConfig.videoParameters = videoParameters;
+            monoConfig.videoParameters = decoderParameters;
             monoConfig.yNRLevel = config.lumaNR;
-            monoDecoder->updateConfiguration(videoParameters, monoConfig);
+            monoDecoder->updateConfiguration(decoderParameters, monoConfig);
             lookBehind = 0;
             lookAhead = 0;
             qInfo() << "Using Mono decoder"
@@ -278,12 +585,90 @@ bool TbcReader::configureDecoder() {
     return true;
 }
 
+void TbcReader::configureMotionBands() {
+    motionDetector = std::make_unique<MotionDetector>(decoderParameters);
+    motionBands.clear();
+    const int rows = motionDetector->getBlockRows();
+    const int numBands = std::min(MOTION_BANDS, rows);
+    const qint32 blockFrameLines = 2 * MotionDetector::BLOCK_LINES;
+    for (int b = 0; b < numBands; b++) {
+        MotionBand &band = motionBands.emplace_back();
+        band.firstRow = b * rows / numBands;
+        band.endRow = (b + 1) * rows / numBands;
+        // The outer bands also take the lines beyond the block rows
+        band.firstLine = b == 0 ? decoderParameters.firstActiveFrameLine
+            : motionDetector->getFirstFrameLine() + band.firstRow * blockFrameLines;
+        band.endLine = b == numBands - 1 ? decoderParameters.lastActiveFrameLine
+            : motionDetector->getFirstFrameLine() + band.endRow * blockFrameLines;
+        band.parameters = narrowedDecoderArea(decoderParameters,
+                                              decoderParameters.activeVideoStart,
+                                              decoderParameters.activeVideoEnd,
+                                              band.firstLine, band.endLine,
+                                              isTransformDecoder(activeDecoder));
+    }
+}
+
+bool TbcReader::buildFilmFrameMap() {
+    source->filmFrames.clear();
+
+    const qint32 numFields = metadata->getNumberOfFields();
+    const qint32 numVideoFrames = metadata->getNumberOfFrames();
+
+    // Video frame (0-based) of every field, for aligning extra sources
+    std::vector<qint32> fieldToFrame(numFields + 1, -1);
+    for (qint32 seqFrame = 1; seqFrame <= numVideoFrames; seqFrame++) {
+        fieldToFrame[metadata->getFirstFieldNumber(seqFrame)] = seqFrame - 1;
+        fieldToFrame[metadata->getSecondFieldNumber(seqFrame)] = seqFrame - 1;
+    }
+
+    // Film-sourced CAV discs carry a picture number only in the first field
+    // of each film frame; the 2 or 3 fields up to the next picture number
+    // belong to the same film frame. Weaving a picture-number field with the
+    // field after it therefore reconstructs the film frame.
+    VbiDecoder vbiDecoder;
+    qint32 shortFilmFrames = 0;
+    qint32 previousStart = -1;
+    for (qint32 fieldNo = 1; fieldNo < numFields; fieldNo++) {
+        const LdDecodeMetaData::Field &field = metadata->getField(fieldNo);
+        if (field.pad) continue;
+        const qint32 pictureNumber = vbiPictureNumber(vbiDecoder, field.vbi);
+        if (pictureNumber < 0) continue;
+
+        const LdDecodeMetaData::Field &nextField = metadata->getField(fieldNo + 1);
+        if (nextField.pad || nextField.isFirstField == field.isFirstField) continue;
+
+        if (previousStart >= 0 && fieldNo - previousStart < 2) shortFilmFrames++;
+        previousStart = fieldNo;
+
+        FilmFrame filmFrame;
+        filmFrame.firstFieldNo = field.isFirstField ? fieldNo : fieldNo + 1;
+        filmFrame.secondFieldNo = field.isFirstField ? fieldNo + 1 : fieldNo;
+        filmFrame.videoFrame = (fieldToFrame[fieldNo] == fieldToFrame[fieldNo + 1])
+            ? fieldToFrame[fieldNo] : -1;
+        filmFrame.pictureNumber = pictureNumber;
+        source->filmFrames.push_back(filmFrame);
+    }
+
+    if (source->filmFrames.empty()) {
+        lastError = "VBI inverse telecine requires CAV picture numbers in the VBI metadata";
+        return false;
+    }
+
+    qInfo() << "VBI inverse telecine:" << static_cast<qint64>(source->filmFrames.size())
+            << "film frames from" << numVideoFrames << "video frames";
+    if (shortFilmFrames > 0) {
+        qWarning() << shortFilmFrames << "film frames span a single field (cadence breaks);"
+                   << "they are woven with the following field";
+    }
+    return true;
+}
+
 void TbcReader::close() {
     if (isOpen) {
-        sourceVideo->close();
-        metadata->clear();
-        extraSources.clear();
-        primaryVbiScanned = false;
+        // Decode contexts may still be using the metadata and files, which
+        // are closed with the last of them
+        metadata = std::make_shared<SharedMetadata>();
+        source = std::make_shared<SourceState>();
         isOpen = false;
     }
 }
@@ -295,41 +680,68 @@ bool TbcReader::addExtraSource(const std::filesystem::path &tbcPath) {
     }
 
     // Scan primary VBI range on first extra source addition
-    if (!primaryVbiScanned) {
-        primaryVbiAvailable = scanVbiFrameRange(*metadata, primaryDiscTypeCav,
-                                                primaryMinVbiFrame, primaryMaxVbiFrame);
-        primaryVbiScanned = true;
-        if (primaryVbiAvailable) {
-            qInfo() << "Primary source VBI range:" << primaryMinVbiFrame << "-" << primaryMaxVbiFrame
-                    << (primaryDiscTypeCav ? "(CAV)" : "(CLV)");
+    if (!source->primaryVbiScanned) {
+        const SharedMetadata::VbiFrameRange &range = metadata->vbiFrameRange();
+        source->primaryVbiAvailable = range.available;
+        source->primaryDiscTypeCav = range.discTypeCav;
+        source->primaryMinVbiFrame = range.minFrame;
+        source->primaryMaxVbiFrame = range.maxFrame;
+        source->primaryVbiScanned = true;
+        if (source->primaryVbiAvailable) {
+            qInfo() << "Primary source VBI range:" << source->primaryMinVbiFrame << "-" << source->primaryMaxVbiFrame
+                    << (source->primaryDiscTypeCav ? "(CAV)" : "(CLV)");
         } else {
             qInfo() << "Primary source has no VBI frame numbers; using sequential alignment for extra sources";
         }
     }
 
-    ExtraSource extra;
-    extra.metadata = std::make_unique<LdDecodeMetaData>();
+    if (isPipeInput(tbcPath)) {
+        lastError = "Extra sources are read out of order and must be files, not pipes";
+        return false;
+    }
+
+    ExtraSource &extra = source->extraSources.emplace_back();
     extra.sourceVideo = std::make_unique<SourceVideo>();
 
     QString tbcPathStr = QString::fromStdString(tbcPath.string());
-    if (!openTbcSource(tbcPathStr, *extra.metadata, *extra.sourceVideo)) {
+    extra.tbcPath = tbcPathStr;
+    if (!openTbcSource(tbcPathStr, extra.metadata, *extra.sourceVideo)) {
+        source->extraSources.pop_back();
         return false;
     }
 
-    // Scan VBI frame range (optional — falls back to sequential alignment)
-    extra.vbiAvailable = scanVbiFrameRange(*extra.metadata, extra.discTypeCav,
-                                            extra.minVbiFrame, extra.maxVbiFrame);
+    // VBI frame range (optional — falls back to sequential alignment)
+    const SharedMetadata::VbiFrameRange &range = extra.metadata->vbiFrameRange();
+    extra.vbiAvailable = range.available;
+    extra.discTypeCav = range.discTypeCav;
+    extra.minVbiFrame = range.minFrame;
+    extra.maxVbiFrame = range.maxFrame;
     if (extra.vbiAvailable) {
-        qInfo() << "Extra source" << extraSources.size() << "VBI range:"
+        qInfo() << "Extra source" << source->extraSources.size() - 1 << "VBI range:"
                 << extra.minVbiFrame << "-" << extra.maxVbiFrame
                 << (extra.discTypeCav ? "(CAV)" : "(CLV)");
     } else {
-        qInfo() << "Extra source" << extraSources.size()
+        qInfo() << "Extra source" << source->extraSources.size() - 1
                 << "has no VBI frame numbers; using sequential alignment ("
                 << extra.metadata->getNumberOfFrames() << "frames)";
     }
 
-    extraSources.push_back(std::move(extra));
+    extra.detectDropouts = shouldDetectDropouts(*extra.metadata);
+    extra.deviceId = fileDeviceId(tbcPath);
+    extra.fieldQuality = std::make_unique<FieldQualityCache>(
+        extra.metadata->getVideoParameters(), extra.metadata->getNumberOfFields());
+    if (!source->fieldQuality) {
+        source->fieldQuality = std::make_unique<FieldQualityCache>(
+            videoParameters, metadata->getNumberOfFields());
+    }
+    return true;
+}
+
+bool TbcReader::shouldDetectDropouts(SharedMetadata &sourceMetadata) const {
+    if (!config.dropoutCorrect || config.dropoutDetect <= 0) return false;
+    if (config.dropoutDetect >= 2) return true;
+    if (sourceMetadata.listsDropouts()) return false;
+    qInfo() << "Metadata lists no dropouts; detecting them from the field samples";
     return true;
 }
 
@@ -349,7 +761,23 @@ int TbcReader::getActiveHeight() const {
     return activeHeight;
 }
 
+std::vector<QString> TbcReader::getMetadataDbPaths() const {
+    std::vector<QString> paths;
+    if (!metadataDbPath.isEmpty()) paths.push_back(metadataDbPath);
+    for (const ExtraSource &extra : source->extraSources) {
+        paths.push_back(extra.metadata->getDbPath());
+    }
+    return paths;
+}
+
 int TbcReader::getNumFrames() const {
+    if (!source->filmFrames.empty()) {
+        return static_cast<int>(source->filmFrames.size());
+    }
+    return metadata->getNumberOfFrames();
+}
+
+int TbcReader::getNumSourceFrames() const {
     return metadata->getNumberOfFrames();
 }
 
@@ -358,6 +786,12 @@ VideoSystem TbcReader::getVideoSystem() const {
 }
 
 TbcReader::FrameRate TbcReader::getFrameRate() const {
+    // Film frames woven from 3:2 pulldown play at film rate slowed to match
+    // the NTSC field rate; PAL film is transferred 2:2 at the video rate.
+    if (!source->filmFrames.empty() && videoParameters.system != PAL) {
+        return {24000, 1001};  // 23.976 fps
+    }
+
     // Return standard frame rates based on video system
     switch (videoParameters.system) {
         case NTSC:
@@ -369,58 +803,6 @@ TbcReader::FrameRate TbcReader::getFrameRate() const {
     }
 }
 
-// Scan all frames in a metadata source to determine VBI frame range.
-// Adapted from CorrectorPool::setMinAndMaxVbiFrames().
-bool TbcReader::scanVbiFrameRange(LdDecodeMetaData &meta, bool &isCav,
-                                   qint32 &minFrame, qint32 &maxFrame) {
-    VbiDecoder vbiDecoder;
-    qint32 cavCount = 0, clvCount = 0;
-    qint32 cavMin = 1000000, cavMax = 0;
-    qint32 clvMin = 1000000, clvMax = 0;
-
-    for (qint32 seqFrame = 1; seqFrame <= meta.getNumberOfFrames(); seqFrame++) {
-        auto vbi1 = meta.getFieldVbi(meta.getFirstFieldNumber(seqFrame)).vbiData;
-        auto vbi2 = meta.getFieldVbi(meta.getSecondFieldNumber(seqFrame)).vbiData;
-        VbiDecoder::Vbi vbi = vbiDecoder.decodeFrame(
-            vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
-
-        if (vbi.picNo > 0) {
-            cavCount++;
-            if (vbi.picNo < cavMin) cavMin = vbi.picNo;
-            if (vbi.picNo > cavMax) cavMax = vbi.picNo;
-        }
-
-        if (vbi.clvHr != -1 && vbi.clvMin != -1 &&
-            vbi.clvSec != -1 && vbi.clvPicNo != -1) {
-            clvCount++;
-            LdDecodeMetaData::ClvTimecode timecode;
-            timecode.hours = vbi.clvHr;
-            timecode.minutes = vbi.clvMin;
-            timecode.seconds = vbi.clvSec;
-            timecode.pictureNumber = vbi.clvPicNo;
-            qint32 cvFrame = meta.convertClvTimecodeToFrameNumber(timecode);
-            if (cvFrame < clvMin) clvMin = cvFrame;
-            if (cvFrame > clvMax) clvMax = cvFrame;
-        }
-    }
-
-    if (cavCount == 0 && clvCount == 0) {
-        return false;
-    }
-
-    if (cavCount > clvCount) {
-        isCav = true;
-        minFrame = cavMin;
-        maxFrame = cavMax;
-    } else {
-        isCav = false;
-        minFrame = clvMin;
-        maxFrame = clvMax;
-    }
-
-    return true;
-}
-
 qint32 TbcReader::vbiToSequential(qint32 vbiFrame, qint32 minVbiFrame) {
     return vbiFrame - minVbiFrame + 1;
 }
@@ -432,40 +814,80 @@ qint32 TbcReader::sequentialToVbi(qint32 seqFrame, qint32 minVbiFrame) {
 void TbcReader::loadExtraSourceFrames(int frameNumber,
                                        QVector<ExtraSourceFrame> &extras) {
     extras.clear();
-    if (extraSources.empty()) return;
+    if (source->extraSources.empty()) return;
 
     // frameNumber is 0-based; sequential frame numbers are 1-based
     qint32 primarySeq = frameNumber + 1;
 
     // Compute primary VBI frame number if VBI alignment is available
-    qint32 primaryVbi = primaryVbiAvailable
-        ? sequentialToVbi(primarySeq, primaryMinVbiFrame) : 0;
+    qint32 primaryVbi = source->primaryVbiAvailable
+        ? sequentialToVbi(primarySeq, source->primaryMinVbiFrame) : 0;
+
+    // One task per device: sources on one disk are read in turn, while
+    // different disks are read at once, so latency follows the slowest disk
+    std::vector<std::vector<size_t>> deviceGroups;
+    for (size_t i = 0; i < source->extraSources.size(); i++) {
+        const qint64 deviceId = source->extraSources[i].deviceId;
+        auto group = std::find_if(deviceGroups.begin(), deviceGroups.end(),
+            [&](const std::vector<size_t> &g) {
+                return deviceId >= 0 && source->extraSources[g.front()].deviceId == deviceId;
+            });
+        if (group == deviceGroups.end()) {
+            deviceGroups.push_back({i});
+        } else {
+            group->push_back(i);
+        }
+    }
 
-    for (size_t i = 0; i < extraSources.size(); i++) {
-        ExtraSource &src = extraSources[i];
+    std::vector<ExtraSourceFrame> frames(source->extraSources.size());
+    std::vector<char> loaded(source->extraSources.size(), 0);
+    auto loadGroup = [&](const std::vector<size_t> &group) {
+        for (size_t i : group) {
+            loaded[i] = loadExtraSourceFrame(source->extraSources[i], primarySeq, primaryVbi, frames[i]);
+        }
+    };
+    std::vector<std::future<void>> tasks;
+    for (size_t g = 1; g < deviceGroups.size(); g++) {
+        tasks.push_back(std::async(std::launch::async, loadGroup, std::cref(deviceGroups[g])));
+    }
+    loadGroup(deviceGroups.front());
+    for (auto &task : tasks) {
+        task.get();
+    }
 
-        qint32 extraSeq;
-        if (primaryVbiAvailable && src.vbiAvailable) {
-            // VBI alignment: map primary VBI → extra sequential
-            if (primaryVbi < src.minVbiFrame || primaryVbi > src.maxVbiFrame) continue;
-            extraSeq = vbiToSequential(primaryVbi, src.minVbiFrame);
-        } else {
-            // Sequential alignment: same frame number, clamped to range
-            extraSeq = primarySeq;
+    // Keep the order sources were added in
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (loaded[i]) {
+            extras.append(std::move(frames[i]));
         }
-        if (extraSeq < 1 || extraSeq > src.metadata->getNumberOfFrames()) continue;
+    }
+}
+
+bool TbcReader::loadExtraSourceFrame(ExtraSource &src, qint32 primarySeq, qint32 primaryVbi,
+                                     ExtraSourceFrame &esf) {
+    qint32 extraSeq;
+    if (source->primaryVbiAvailable && src.vbiAvailable) {
+        // VBI alignment: map primary VBI → extra sequential
+        if (primaryVbi < src.minVbiFrame || primaryVbi > src.maxVbiFrame) return false;
+        extraSeq = vbiToSequential(primaryVbi, src.minVbiFrame);
+    } else {
+        // Sequential alignment: same frame number, clamped to range
+        extraSeq = primarySeq;
+    }
+    if (extraSeq < 1 || extraSeq > src.metadata->getNumberOfFrames()) return false;
 
-        qint32 firstFieldNo = src.metadata->getFirstFieldNumber(extraSeq);
-        qint32 secondFieldNo = src.metadata->getSecondFieldNumber(extraSeq);
+    qint32 firstFieldNo = src.metadata->getFirstFieldNumber(extraSeq);
+    qint32 secondFieldNo = src.metadata->getSecondFieldNumber(extraSeq);
 
-        // Skip padded (missing) frames
-        if (src.metadata->getField(firstFieldNo).pad &&
-            src.metadata->getField(secondFieldNo).pad) continue;
+    // Skip padded (missing) frames
+    if (src.metadata->getField(firstFieldNo).pad &&
+        src.metadata->getField(secondFieldNo).pad) return false;
 
-        ExtraSourceFrame esf;
-        esf.videoParams = src.metadata->getVideoParameters();
+    esf.videoParams = src.metadata->getVideoParameters();
 
-        // Load field data (read in TBC sequential order to minimize seeking)
+    // Load field data (read in TBC sequential order to minimize seeking)
+    {
+        std::lock_guard<std::mutex> lock(src.readMutex);
         if (firstFieldNo < secondFieldNo) {
             esf.firstFieldData = src.sourceVideo->getVideoField(firstFieldNo);
             esf.secondFieldData = src.sourceVideo->getVideoField(secondFieldNo);
@@ -473,35 +895,301 @@ void TbcReader::loadExtraSourceFrames(int frameNumber,
             esf.secondFieldData = src.sourceVideo->getVideoField(secondFieldNo);
             esf.firstFieldData = src.sourceVideo->getVideoField(firstFieldNo);
         }
+    }
 
-        esf.firstFieldMeta = src.metadata->getField(firstFieldNo);
-        esf.secondFieldMeta = src.metadata->getField(secondFieldNo);
+    esf.firstFieldMeta = src.metadata->getField(firstFieldNo);
+    esf.secondFieldMeta = src.metadata->getField(secondFieldNo);
+    if (src.detectDropouts) {
+        DropoutDetector detector(esf.videoParams);
+        detector.detect(esf.firstFieldData, esf.firstFieldMeta.dropOuts);
+        detector.detect(esf.secondFieldData, esf.secondFieldMeta.dropOuts);
+    }
 
-        // Quality from average bPSNR
-        esf.quality = (esf.firstFieldMeta.vitsMetrics.bPSNR
-                      + esf.secondFieldMeta.vitsMetrics.bPSNR) / 2.0;
+    // Quality from the fields' measured noise
+    esf.quality = (src.fieldQuality->quality(firstFieldNo, esf.firstFieldData)
+                   + src.fieldQuality->quality(secondFieldNo, esf.secondFieldData)) / 2.0;
+    return true;
+}
 
-        extras.append(std::move(esf));
+bool TbcReader::readFieldPair(qint32 firstFieldNo, qint32 secondFieldNo,
+                              SourceVideo::Data &firstData, SourceVideo::Data &secondData) {
+    // Read in TBC sequential order to minimize seeking (and as pipes need)
+    const bool firstIsEarlier = firstFieldNo < secondFieldNo;
+    const qint32 fieldNos[2] = { firstIsEarlier ? firstFieldNo : secondFieldNo,
+                                 firstIsEarlier ? secondFieldNo : firstFieldNo };
+    SourceVideo::Data *datas[2] = { firstIsEarlier ? &firstData : &secondData,
+                                    firstIsEarlier ? &secondData : &firstData };
+    std::lock_guard<std::mutex> lock(source->readMutex);
+    for (int i = 0; i < 2; i++) {
+        if (source->pipeSource) {
+            if (!source->pipeSource->getVideoField(fieldNos[i], *datas[i])) {
+                lastError = source->pipeSource->getLastError();
+                return false;
+            }
+        } else {
+            *datas[i] = source->sourceVideo->getVideoField(fieldNos[i]);
+        }
     }
+    return true;
 }
 
 bool TbcReader::loadFieldsForFrame(int frameNumber, QVector<SourceField> &fields,
                                     qint32 &startIndex, qint32 &endIndex) {
-    // Load fields using SourceField's static method
-    // Frame numbers are 1-based in ld-decode
-    SourceField::loadFields(*sourceVideo, *metadata,
-                           frameNumber + 1,  // Convert to 1-based
-                           1,                 // Number of frames
-                           lookBehind,
-                           lookAhead,
-                           fields,
-                           startIndex, endIndex);
+    // Same layout as SourceField::loadFields: the frame's fields at
+    // startIndex, after lookBehind frames and before lookAhead frames. Each
+    // frame's pair is read under readMutex on its own, so other contexts'
+    // reads interleave rather than wait for the whole window.
+    startIndex = 2 * lookBehind;
+    endIndex = startIndex + 2;
+    fields.resize(endIndex + (2 * lookAhead));
+
+    // Beyond either end of the TBC, as in ld-chroma-decoder, the window has
+    // black fields with this frame's metadata. Film frames (so temporal
+    // decoders see neighbouring film frames) and pipes (which can't be read
+    // back) repeat the nearest frame instead.
+    const bool blankEnds = source->filmFrames.empty() && !source->pipeSource;
+    const qint32 lastFrame = getNumFrames() - 1;
+    for (qint32 i = 0; i < fields.size(); i += 2) {
+        const qint32 windowFrame = frameNumber - lookBehind + (i / 2);
+        const bool blank = blankEnds && (windowFrame < 0 || windowFrame > lastFrame);
+        const qint32 lookupFrame = blank ? frameNumber : std::clamp(windowFrame, 0, lastFrame);
+        qint32 firstFieldNo, secondFieldNo;
+        if (!source->filmFrames.empty()) {
+            firstFieldNo = source->filmFrames[lookupFrame].firstFieldNo;
+            secondFieldNo = source->filmFrames[lookupFrame].secondFieldNo;
+        } else {
+            firstFieldNo = metadata->getFirstFieldNumber(lookupFrame + 1);
+            secondFieldNo = metadata->getSecondFieldNumber(lookupFrame + 1);
+        }
+        fields[i].field = metadata->getField(firstFieldNo);
+        fields[i + 1].field = metadata->getField(secondFieldNo);
+        if (blank) {
+            fields[i].data.fill(static_cast<quint16>(videoParameters.black16bIre),
+                                videoParameters.fieldWidth * videoParameters.fieldHeight);
+            fields[i + 1].data = fields[i].data;
+        } else if (!readFieldPair(firstFieldNo, secondFieldNo, fields[i].data, fields[i + 1].data)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TbcReader::correctFrameFields(int videoFrame, SourceField &firstField,
+                                   SourceField &secondField,
+                                   DropoutCorrectionStats *stats) {
+    // Accumulate into a per-frame total so a cached result can replay it
+    auto addStats = [stats](const DropoutCorrectionStats &frameStats,
+                            const QVector<DropoutSpan> &frameUnresolved) {
+        if (stats) {
+            stats->add(frameStats);
+            if (stats->unresolved) {
+                for (const DropoutSpan &span : frameUnresolved) {
+                    stats->unresolved->append(span);
+                }
+            }
+        }
+    };
+
+    // Decode contexts share the cache, so a frame corrected by one is
+    // reused by the others
+    auto findCached = [this](qint32 firstFieldNo) {
+        return std::find_if(source->correctedFrames.begin(), source->correctedFrames.end(),
+            [firstFieldNo](const CorrectedFrame &cached) {
+                return cached.firstFieldNo == firstFieldNo;
+            });
+    };
+    if (config.correctedFrameCacheSize > 0) {
+        std::lock_guard<std::mutex> lock(source->cacheMutex);
+        const auto cached = findCached(firstField.field.seqNo);
+        if (cached != source->correctedFrames.end()) {
+            firstField.data = cached->firstFieldData;
+            secondField.data = cached->secondFieldData;
+            firstField.field.dropOuts = cached->firstDropOuts;
+            secondField.field.dropOuts = cached->secondDropOuts;
+            addStats(cached->stats, cached->unresolved);
+            return true;
+        }
+    }
+
+    // The fields as loaded, restored if correction fails partway (the
+    // copies share the loaded samples until correction writes to them)
+    const SourceField uncorrectedFirst = firstField;
+    const SourceField uncorrectedSecond = secondField;
+
+    QVector<DropoutSpan> frameUnresolved;
+    DropoutCorrectionStats frameStats;
+    frameStats.unresolved = &frameUnresolved;
+    try {
+        if (source->detectDropouts) {
+            DropoutDetector detector(videoParameters);
+            detector.detect(firstField.data, firstField.field.dropOuts);
+            detector.detect(secondField.data, secondField.field.dropOuts);
+        }
+
+        DropoutCorrector corrector(videoParameters);
+        const bool hasDropouts = !firstField.field.dropOuts.empty() ||
+                                 !secondField.field.dropOuts.empty();
+        if (!source->extraSources.empty() && videoFrame >= 0 && hasDropouts) {
+            // Extra sources are only read (and ranked) for frames needing them
+            QVector<ExtraSourceFrame> extras;
+            loadExtraSourceFrames(videoFrame, extras);
+            const double primaryQuality =
+                (source->fieldQuality->quality(firstField.field.seqNo, firstField.data)
+                 + source->fieldQuality->quality(secondField.field.seqNo, secondField.data)) / 2.0;
+            corrector.correctFrame(firstField, secondField,
+                                   extras, primaryQuality, config.dropoutOvercorrect,
+                                   config.dropoutIntra, &frameStats);
+        } else {
+            corrector.correctFrame(firstField, secondField,
+                                   config.dropoutOvercorrect, config.dropoutIntra,
+                                   &frameStats);
+        }
+    } catch (const std::exception &e) {
+        firstField = uncorrectedFirst;
+        secondField = uncorrectedSecond;
+        lastError = QString("Dropout correction failed for field %1: %2")
+            .arg(firstField.field.seqNo).arg(QString::fromUtf8(e.what()));
+        return false;
+    }
+    frameStats.unresolved = nullptr;
+    addStats(frameStats, frameUnresolved);
+
+    if (config.correctedFrameCacheSize > 0) {
+        std::lock_guard<std::mutex> lock(source->cacheMutex);
+        // Another context may have corrected the same frame meanwhile
+        if (findCached(firstField.field.seqNo) != source->correctedFrames.end()) return true;
+        if (static_cast<int>(source->correctedFrames.size()) >= config.correctedFrameCacheSize) {
+            source->correctedFrames.pop_front();
+        }
+        source->correctedFrames.push_back({firstField.field.seqNo, firstField.data, secondField.data,
+                                   firstField.field.dropOuts, secondField.field.dropOuts,
+                                   frameStats, frameUnresolved});
+    }
+}
+
+bool TbcReader::loadFirstField(int frameNumber, SourceVideo::Data &data) {
+    if (!isOpen || frameNumber < 0 || frameNumber >= getNumSourceFrames()) {
+        lastError = "Frame number out of range";
+        return false;
+    }
+    if (source->pipeSource) {
+        lastError = "Single fields can't be read from a pipe";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(source->readMutex);
+    data = source->sourceVideo->getVideoField(metadata->getFirstFieldNumber(frameNumber + 1));
+    return true;
+}
+
+bool TbcReader::frameHasDropouts(int frameNumber) {
+    if (!isOpen || frameNumber < 0 || frameNumber >= getNumSourceFrames()) {
+        return false;
+    }
+    // Detected dropouts aren't known until the fields are scanned
+    if (source->detectDropouts) return true;
+    const qint32 frameSeq = frameNumber + 1;
+    return !metadata->getField(metadata->getFirstFieldNumber(frameSeq)).dropOuts.empty()
+        || !metadata->getField(metadata->getSecondFieldNumber(frameSeq)).dropOuts.empty();
+}
+
+QVector<qint32> TbcReader::getRepeatSourceFrames() const {
+    QVector<qint32> sources;
+    if (!isOpen) return sources;
+
+    const qint32 numFrames = getNumFrames();
+    sources.resize(numFrames);
+
+    VbiDecoder vbiDecoder;
+    qint32 runStart = -1;
+    qint32 runPictureNumber = -1;
+    for (qint32 frame = 0; frame < numFrames; frame++) {
+        sources[frame] = frame;
+
+        qint32 pictureNumber;
+        bool pad = false;
+        if (!source->filmFrames.empty()) {
+            pictureNumber = source->filmFrames[frame].pictureNumber;
+        } else {
+            const LdDecodeMetaData::Field &first =
+                metadata->getField(metadata->getFirstFieldNumber(frame + 1));
+            const LdDecodeMetaData::Field &second =
+                metadata->getField(metadata->getSecondFieldNumber(frame + 1));
+            pad = first.pad && second.pad;
+            pictureNumber = vbiPictureNumber(vbiDecoder, first.vbi, &second.vbi);
+        }
+
+        if (pad && runStart >= 0) {
+            // Pad frames hold no picture; show the last real one
+            sources[frame] = runStart;
+        } else if (pictureNumber >= 0 && pictureNumber == runPictureNumber) {
+            sources[frame] = runStart;
+        } else if (!pad) {
+            runStart = frame;
+            runPictureNumber = pictureNumber;
+        }
+    }
+    return sources;
+}
 
-    return fields.size() > 0;
+bool TbcReader::loadCorrectedFields(int frameNumber, SourceField &firstField,
+                                    SourceField &secondField,
+                                    DropoutCorrectionStats *stats) {
+    if (!isOpen) {
+        lastError = "TBC file not open";
+        return false;
+    }
+
+    if (frameNumber < 0 || frameNumber >= getNumSourceFrames()) {
+        lastError = "Frame number out of range";
+        return false;
+    }
+
+    const qint32 frameSeq = frameNumber + 1;
+    const qint32 firstFieldNo = metadata->getFirstFieldNumber(frameSeq);
+    const qint32 secondFieldNo = metadata->getSecondFieldNumber(frameSeq);
+
+    firstField.field = metadata->getField(firstFieldNo);
+    secondField.field = metadata->getField(secondFieldNo);
+    if (!readFieldPair(firstFieldNo, secondFieldNo, firstField.data, secondField.data)) {
+        return false;
+    }
+
+    return !config.dropoutCorrect || correctFrameFields(frameNumber, firstField, secondField, stats);
+}
+
+int TbcReader::findMovingBands(const QVector<SourceField> &fields, qint32 startIndex,
+                               std::vector<char> &bandMoving) const {
+    bandMoving.assign(motionBands.size(), 0);
+    if (startIndex < 2 || startIndex + 1 >= fields.size()) return 0;
+
+    // Field reversal only swapped the frame's own pair
+    const SourceVideo::Data *const current[2] = {
+        &fields[startIndex].data, &fields[startIndex + 1].data };
+    const int previousFirst = config.reverseFields ? 1 : 0;
+    const SourceVideo::Data *const previous[2] = {
+        &fields[startIndex - 2 + previousFirst].data,
+        &fields[startIndex - 1 - previousFirst].data };
+    std::vector<int> movingPerRow;
+    if (!motionDetector->detect(current, previous, movingPerRow)) return 0;
+
+    int movingBands = 0;
+    for (size_t b = 0; b < motionBands.size(); b++) {
+        const MotionBand &band = motionBands[b];
+        qint64 moving = 0;
+        for (int row = band.firstRow; row < band.endRow; row++) {
+            moving += movingPerRow[row];
+        }
+        const qint64 blocks = 2LL * motionDetector->getBlocksAcross() * (band.endRow - band.firstRow);
+        if (blocks > 0 && static_cast<double>(moving) / blocks >= config.motionSkip) {
+            bandMoving[b] = 1;
+            movingBands++;
+        }
+    }
+    return movingBands;
 }
 
 bool TbcReader::decodeFrame(int frameNumber, ComponentFrame &frame,
-                            DropoutCorrectionStats *stats) {
+                            DropoutCorrectionStats *stats, SourceField *frameFields) {
     if (!isOpen) {
         lastError = "TBC file not open";
         return false;
@@ -517,7 +1205,8 @@ bool TbcReader::decodeFrame(int frameNumber, ComponentFrame &frame,
     qint32 startIndex = 0, endIndex = 0;
 
     if (!loadFieldsForFrame(frameNumber, fields, startIndex, endIndex)) {
-        lastError = "Failed to load fields for frame " + QString::number(frameNumber);
+        lastError = "Failed to load fields for frame " + QString::number(frameNumber)
+            + (source->pipeSource ? ": " + source->pipeSource->getLastError() : QString());
         return false;
     }
 
@@ -533,24 +1222,50 @@ bool TbcReader::decodeFrame(int frameNumber, ComponentFrame &frame,
 
     // Apply dropout correction to the raw TBC field data before chroma decoding
     if (config.dropoutCorrect && (startIndex + 1) < fields.size()) {
-        DropoutCorrector corrector(videoParameters);
-        if (!extraSources.empty()) {
-            QVector<ExtraSourceFrame> extras;
-            loadExtraSourceFrames(frameNumber, extras);
-            corrector.correctFrame(fields[startIndex], fields[startIndex + 1],
-                                   extras, config.dropoutOvercorrect,
-                                   config.dropoutIntra, stats);
-        } else {
-            corrector.correctFrame(fields[startIndex], fields[startIndex + 1],
-                                   config.dropoutOvercorrect, config.dropoutIntra,
-                                   stats);
+        // A film frame straddling two video frames has no single video frame
+        // to align extra sources with, so it is corrected from this source only
+        const int videoFrame = source->filmFrames.empty()
+            ? frameNumber : source->filmFrames[frameNumber].videoFrame;
+        if (!correctFrameFields(videoFrame, fields[startIndex], fields[startIndex + 1], stats)) {
+            return false;
         }
     }
 
-    // Initialize output frame
-    QVector<ComponentFrame> componentFrames;
-    componentFrames.resize(1);
-    componentFrames[0].init(videoParameters);
+    if (frameFields && (startIndex + 1) < fields.size()) {
+        frameFields[0] = fields[startIndex];
+        frameFields[1] = fields[startIndex + 1];
+    }
+
+    // Initialize output frame (init() resizes, so a reused buffer keeps
+    // its allocation)
+    decodeBuffers.resize(1);
+    QVector<ComponentFrame> &componentFrames = decodeBuffers;
+    componentFrames[0].init(decoderParameters);
+
+    // Bands that moved almost everywhere come from the 2D decoder, which
+    // the 3D decoder would fall back to there anyway. A frame that moved
+    // everywhere skips the 3D decode; otherwise the moving bands are decoded
+    // again in 2D over the 3D decode, which the static bands keep as is.
+    std::vector<char> bandMoving;
+    const int movingBands = motionBands.empty()
+        ? 0 : findMovingBands(fields, startIndex, bandMoving);
+    const bool allMoving = movingBands == static_cast<int>(motionBands.size());
+    auto decodeMovingBands = [&](auto bandDecoder) {
+        bandBuffers.resize(1);
+        for (size_t b = 0; b < motionBands.size(); b++) {
+            if (!bandMoving[b]) continue;
+            const MotionBand &band = motionBands[b];
+            bandBuffers[0].init(band.parameters);
+            (band.*bandDecoder)->decodeFrames(fields, startIndex, endIndex, bandBuffers);
+            const qint32 start = decoderParameters.activeVideoStart;
+            const qint32 count = decoderParameters.activeVideoEnd - start;
+            for (qint32 line = band.firstLine; line < band.endLine; line++) {
+                std::copy_n(bandBuffers[0].y(line) + start, count, componentFrames[0].y(line) + start);
+                std::copy_n(bandBuffers[0].u(line) + start, count, componentFrames[0].u(line) + start);
+                std::copy_n(bandBuffers[0].v(line) + start, count, componentFrames[0].v(line) + start);
+            }
+        }
+    };
 
     // Decode using the appropriate decoder
     switch (activeDecoder) {
@@ -558,13 +1273,23 @@ bool TbcReader::decodeFrame(int frameNumber, ComponentFrame &frame,
         case DecoderType::Ntsc2D:
         case DecoderType::Ntsc3D:
         case DecoderType::Ntsc3DNoAdapt:
-            combFilter->decodeFrames(fields, startIndex, endIndex, componentFrames);
+            if (movingBands > 0 && allMoving) {
+                fallbackCombFilter->decodeFrames(fields, startIndex, endIndex, componentFrames);
+            } else {
+                combFilter->decodeFrames(fields, startIndex, endIndex, componentFrames);
+                if (movingBands > 0) decodeMovingBands(&MotionBand::combFilter);
+            }
             break;
 
         case DecoderType::Pal2D:
         case DecoderType::Transform2D:
         case DecoderType::Transform3D:
-            palColour->decodeFrames(fields, startIndex, endIndex, componentFrames);
+            if (movingBands > 0 && allMoving) {
+                fallbackPalColour->decodeFrames(fields, startIndex, endIndex, componentFrames);
+            } else {
+                palColour->decodeFrames(fields, startIndex, endIndex, componentFrames);
+                if (movingBands > 0) decodeMovingBands(&MotionBand::palColour);
+            }
             break;
 
         case DecoderType::Mono:
@@ -576,6 +1301,6 @@ bool TbcReader::decodeFrame(int frameNumber, ComponentFrame &frame,
             return false;
     }
 
-    frame = std::move(componentFrames[0]);
+    std::swap(frame, componentFrames[0]);
     return true;
 }
@@ -10,7 +10,9 @@
 
 #include <QString>
 #include <QVector>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <filesystem>
 
@@ -22,6 +24,11 @@
 #include "palcolour.h"
 #include "monodecoder.h"
 #include "dropoutcorrector.h"
+#include "fieldquality.h"
+#include "motiondetector.h"
+#include "sharedmetadata.h"
+
+class PipeFieldSource;
 
 // TBC file reader that wraps ld-decode-tools' TBC library
 class TbcReader {
@@ -54,6 +61,24 @@ public:
         bool dropoutCorrect = false;     // Enable dropout correction
         bool dropoutOvercorrect = false; // Extend dropout boundaries (±24 samples)
         bool dropoutIntra = false;       // Intra-field only correction
+        int correctedFrameCacheSize = 0; // Dropout-corrected frames kept for reuse (0 = off)
+        // Find dropouts in the field samples: 0 = off, 1 = for sources whose
+        // metadata lists none, 2 = always (added to the listed ones)
+        int dropoutDetect = 0;
+        bool ivtcVbi = false;            // Weave film frames located by VBI picture numbers
+        // Samples/frame lines cropped off the active area, inside the decode
+        int cropLeft = 0;
+        int cropTop = 0;
+        int cropRight = 0;
+        int cropBottom = 0;
+        // With ntsc3d or transform3d, bands of the frame where at least this
+        // share of blocks moved since the previous frame are decoded by the
+        // 2D decoder, which the 3D decoders fall back to in moving areas
+        // (0 = off)
+        double motionSkip = 0.0;
+        // Metadata sidecar (.db or .json) to use instead of looking next to
+        // the TBC; required for pipe input
+        std::filesystem::path metadataPath;
         DecoderType decoder = DecoderType::Auto;
     };
 
@@ -64,14 +89,25 @@ public:
     TbcReader();
     ~TbcReader();
 
-    // Open a TBC file and its metadata with optional fallback metadata
+    // Open a TBC file and its metadata with optional fallback metadata.
+    // A path of "-" (standard input) or a FIFO is read sequentially through
+    // a PipeFieldSource: frames must then be requested roughly in order.
     bool open(const std::filesystem::path &tbcPath, const Configuration &config,
               const QString &fallbackMetadataDbPath = QString());
     void close();
 
+    // Open another reader of the same source for decoding on another
+    // thread. It shares this reader's metadata, files, extra sources and
+    // corrected frame cache, and gets its own decoder. Extra sources must
+    // be added before. Not possible for pipe input.
+    // Returns null on failure, with the error in getLastError().
+    std::unique_ptr<TbcReader> createDecodeContext();
+
     // Path of the SQLite metadata DB actually used for this source
     // (after any JSON→SQLite conversion). Empty until open() succeeds.
     QString getMetadataDbPath() const { return metadataDbPath; }
+    // Metadata DBs used by this source and each of its extra sources
+    std::vector<QString> getMetadataDbPaths() const;
 
     struct FrameRate {
         int64_t num;
@@ -81,65 +117,191 @@ public:
     // Get video properties
     int getWidth() const;
     int getHeight() const;
-    int getActiveWidth() const;   // Width before padding
-    int getActiveHeight() const;  // Height before padding
+    int getActiveWidth() const;   // Width before padding (after cropping)
+    int getActiveHeight() const;  // Height before padding (after cropping)
     int getNumFrames() const;
+    int getNumSourceFrames() const;  // Video frames in the TBC (differs with ivtcVbi)
+    bool isIvtc() const { return !source->filmFrames.empty(); }
+    bool isPipe() const { return source->pipeSource != nullptr; }
     VideoSystem getVideoSystem() const;
     FrameRate getFrameRate() const;
     bool isMonoDecoder() const { return activeDecoder == DecoderType::Mono; }
     bool isWidescreen() const { return videoParameters.isWidescreen; }
-    int getFirstActiveFrameLine() const { return videoParameters.firstActiveFrameLine; }
+    int getFirstActiveFrameLine() const { return firstOutputLine; }  // After cropping
 
     // Get video parameters for YCbCr scaling (black/white IRE levels)
     double getBlack16bIre() const { return static_cast<double>(videoParameters.black16bIre); }
     double getWhite16bIre() const { return static_cast<double>(videoParameters.white16bIre); }
 
-    // Get active region offsets (for extracting from ComponentFrame)
-    int getActiveVideoStart() const { return videoParameters.activeVideoStart; }
+    // Get active region offsets (for extracting from ComponentFrame), after cropping
+    int getActiveVideoStart() const { return outputVideoStart; }
+
+    // Samples per line of raw field data
+    int getFieldWidth() const { return videoParameters.fieldWidth; }
+
+    // Video parameters as read from the metadata, before cropping
+    const LdDecodeMetaData::VideoParameters &getVideoParameters() const { return videoParameters; }
 
     // Add an extra source for multi-source dropout correction.
     // Extra sources are aligned to the primary via VBI frame numbers.
-    // Returns true on success. Must be called after open().
+    // Returns true on success. Must be called after open() and before
+    // createDecodeContext().
     bool addExtraSource(const std::filesystem::path &tbcPath);
 
     // Decode a frame to Y'CbCr (returns ComponentFrame with Y, U, V planes)
+    // The reader's decode buffer is swapped with frame, so passing the same
+    // frame for every decode recycles both allocations.
     // If stats is non-null, accumulates dropout correction statistics.
+    // If frameFields is non-null, it receives the frame's two fields as
+    // decoded (after field reversal and dropout correction).
     bool decodeFrame(int frameNumber, ComponentFrame &frame,
-                     DropoutCorrectionStats *stats = nullptr);
+                     DropoutCorrectionStats *stats = nullptr,
+                     SourceField *frameFields = nullptr);
+
+    // Load a video frame's two fields in TBC order (first field, second
+    // field) and dropout-correct them if enabled, without decoding.
+    // Frame numbers are video frames even when ivtcVbi is enabled.
+    // If stats is non-null, accumulates dropout correction statistics.
+    bool loadCorrectedFields(int frameNumber, SourceField &firstField,
+                             SourceField &secondField,
+                             DropoutCorrectionStats *stats = nullptr);
+
+    // Read a video frame's first field as stored, without dropout correction
+    bool loadFirstField(int frameNumber, SourceVideo::Data &data);
+
+    // Whether either field of a video frame has dropouts listed in its metadata
+    bool frameHasDropouts(int frameNumber);
+
+    // For each output frame, the frame whose picture it repeats: the first
+    // frame of a run sharing one CAV picture number (still frames, held
+    // pictures), or the frame before a run of pad frames. Frames that
+    // repeat nothing map to themselves.
+    QVector<qint32> getRepeatSourceFrames() const;
 
     // Get the last error message
     QString getLastError() const { return lastError; }
 
 private:
-    std::unique_ptr<LdDecodeMetaData> metadata;
-    std::unique_ptr<SourceVideo> sourceVideo;
+    std::shared_ptr<SharedMetadata> metadata;  // Shared with decode contexts
+    QString tbcPath;
 
     // Extra sources for multi-source dropout correction
     struct ExtraSource {
-        std::unique_ptr<LdDecodeMetaData> metadata;
+        std::shared_ptr<SharedMetadata> metadata;
+        std::unique_ptr<FieldQualityCache> fieldQuality;
         std::unique_ptr<SourceVideo> sourceVideo;
+        std::mutex readMutex;  // Held while reading sourceVideo
+        QString tbcPath;
         bool vbiAvailable = false;
         bool discTypeCav = false;
+        bool detectDropouts = false;
+        qint64 deviceId = -1;  // Device holding the TBC (-1 if unknown)
         qint32 minVbiFrame = 0;
         qint32 maxVbiFrame = 0;
     };
-    std::vector<ExtraSource> extraSources;
 
-    // VBI frame alignment for multi-source dropout correction.
-    // If VBI data is unavailable, falls back to sequential alignment.
-    bool primaryVbiScanned = false;
-    bool primaryVbiAvailable = false;
-    bool primaryDiscTypeCav = false;
-    qint32 primaryMinVbiFrame = 0;
-    qint32 primaryMaxVbiFrame = 0;
+    // Film frames located via VBI picture numbers (ivtcVbi), in output order.
+    // Each is a pair of opposite-parity fields woven into one progressive
+    // frame; fields are 1-based sequence numbers.
+    struct FilmFrame {
+        qint32 firstFieldNo;   // Field with isFirstField set (even frame lines)
+        qint32 secondFieldNo;  // Other field (odd frame lines)
+        qint32 videoFrame;     // 0-based video frame holding both fields, or -1
+        qint32 pictureNumber;
+    };
+
+    // Recently dropout-corrected field pairs (most recent at the back), so
+    // that re-requesting a frame skips loading extra sources and correction.
+    // Keyed by the first field's sequence number.
+    struct CorrectedFrame {
+        qint32 firstFieldNo;
+        SourceVideo::Data firstFieldData;
+        SourceVideo::Data secondFieldData;
+        DropOuts firstDropOuts;   // Including detected dropouts
+        DropOuts secondDropOuts;
+        DropoutCorrectionStats stats;
+        QVector<DropoutSpan> unresolved;
+    };
+
+    // The source's files and what open() and addExtraSource() found out
+    // about them, shared by a reader and its decode contexts. Besides the
+    // mutex-guarded file reads and frame cache, it doesn't change once
+    // decode contexts exist.
+    struct SourceState {
+        SourceState();
+        ~SourceState();
+
+        std::unique_ptr<SourceVideo> sourceVideo;
+        std::unique_ptr<PipeFieldSource> pipeSource;  // Instead of sourceVideo for pipe input
+        std::mutex readMutex;  // Held while reading sourceVideo or pipeSource
+
+        // Sources are never moved once added, as they hold their mutex
+        std::deque<ExtraSource> extraSources;
+
+        // The primary's field SNRs for ranking it against extra sources (the
+        // metadata's VITS metrics aren't read)
+        std::unique_ptr<FieldQualityCache> fieldQuality;
+
+        // Whether the primary source's dropouts are found by DropoutDetector
+        bool detectDropouts = false;
+
+        // VBI frame alignment for multi-source dropout correction.
+        // If VBI data is unavailable, falls back to sequential alignment.
+        bool primaryVbiScanned = false;
+        bool primaryVbiAvailable = false;
+        bool primaryDiscTypeCav = false;
+        qint32 primaryMinVbiFrame = 0;
+        qint32 primaryMaxVbiFrame = 0;
+
+        std::vector<FilmFrame> filmFrames;
+
+        std::mutex cacheMutex;  // Held while using correctedFrames
+        std::deque<CorrectedFrame> correctedFrames;
+    };
+    std::shared_ptr<SourceState> source;
+
+    bool shouldDetectDropouts(SharedMetadata &sourceMetadata) const;
 
     // Decoders - only one will be active at a time
     std::unique_ptr<Comb> combFilter;          // For NTSC
     std::unique_ptr<PalColour> palColour;      // For PAL
     std::unique_ptr<MonoDecoder> monoDecoder;  // For mono
 
+    // 2D counterparts of a 3D decoder for high-motion areas (motionSkip)
+    std::unique_ptr<Comb> fallbackCombFilter;
+    std::unique_ptr<PalColour> fallbackPalColour;
+
+    // With motionSkip, the decoded area in horizontal bands of whole rows of
+    // motion blocks. A frame where every band moved is decoded by the 2D
+    // fallback alone. Otherwise it is decoded in 3D, and each band that
+    // moved is decoded again by its own 2D decoder, confined to the band
+    // plus filter margins.
+    struct MotionBand {
+        int firstRow = 0;      // Rows of motion blocks, as [firstRow, endRow)
+        int endRow = 0;
+        qint32 firstLine = 0;  // Frame lines taken from the band's decode
+        qint32 endLine = 0;
+        LdDecodeMetaData::VideoParameters parameters;
+        std::unique_ptr<Comb> combFilter;
+        std::unique_ptr<PalColour> palColour;
+    };
+    std::unique_ptr<MotionDetector> motionDetector;
+    std::vector<MotionBand> motionBands;
+    QVector<ComponentFrame> bandBuffers;
+
+    // Set up motionDetector and motionBands over decoderParameters
+    void configureMotionBands();
+    // Mark the bands of the frame at startIndex that moved since the
+    // previous frame of the window. Returns how many did (0 if the window
+    // has no previous frame).
+    int findMovingBands(const QVector<SourceField> &fields, qint32 startIndex,
+                        std::vector<char> &bandMoving) const;
+
     DecoderType activeDecoder = DecoderType::Auto;
     LdDecodeMetaData::VideoParameters videoParameters;
+    // videoParameters with the active area narrowed to the cropped output
+    // plus filter margins; the chroma decoders only process this area
+    LdDecodeMetaData::VideoParameters decoderParameters;
     Configuration config;
     QString lastError;
     QString metadataDbPath;  // SQLite metadata db actually used by this source
@@ -150,11 +312,16 @@ private:
     int outputHeight = 0;
     int activeWidth = 0;   // Width before padding
     int activeHeight = 0;  // Height before padding
+    int firstOutputLine = 0;   // Frame line of the first output line
+    int outputVideoStart = 0;  // Sample of the first output column
 
     // Look-behind/look-ahead for current decoder
     qint32 lookBehind = 0;
     qint32 lookAhead = 0;
 
+    // Decoder output, swapped with the caller's frame after each decode
+    QVector<ComponentFrame> decodeBuffers;
+
     // Helper to load fields for a frame
     bool loadFieldsForFrame(int frameNumber, QVector<SourceField> &fields,
                             qint32 &startIndex, qint32 &endIndex);
@@ -163,22 +330,50 @@ private:
     // objects. If the TBC has no sidecar of its own and fallbackMetadataDbPath
     // names an existing DB, that DB is used.
     bool openTbcSource(const QString &tbcPathStr,
-                       LdDecodeMetaData &meta, SourceVideo &video,
+                       std::shared_ptr<SharedMetadata> &meta, SourceVideo &video,
                        const QString &fallbackMetadataDbPath = QString());
+    // Find (converting JSON if needed) and read a TBC's metadata, sharing it
+    // with any other reader of the same DB. An explicit metadata path
+    // overrides the lookup next to the TBC.
+    bool readTbcMetadata(const QString &tbcPathStr, std::shared_ptr<SharedMetadata> &meta,
+                         const QString &fallbackMetadataDbPath,
+                         const QString &explicitMetadataPath = QString());
+
+    // Read a frame's two fields of the primary source, in TBC order
+    bool readFieldPair(qint32 firstFieldNo, qint32 secondFieldNo,
+                       SourceVideo::Data &firstData, SourceVideo::Data &secondData);
+
+    // Apply the configured crop: set the output area and decoderParameters
+    bool applyCrop();
 
     // Configure the appropriate decoder based on video system and settings
     bool configureDecoder();
 
+    // Build filmFrames from the VBI picture numbers of every field
+    bool buildFilmFrameMap();
+
     // VBI alignment helpers for multi-source dropout correction
-    bool scanVbiFrameRange(LdDecodeMetaData &meta, bool &isCav,
-                           qint32 &minFrame, qint32 &maxFrame);
     qint32 vbiToSequential(qint32 vbiFrame, qint32 minVbiFrame);
     qint32 sequentialToVbi(qint32 seqFrame, qint32 minVbiFrame);
 
     // Load extra source fields for a given primary frame number
-    // and build the ExtraSourceFrame vector for DropoutCorrector
+    // and build the ExtraSourceFrame vector for DropoutCorrector.
+    // Sources on different devices are read concurrently.
     void loadExtraSourceFrames(int frameNumber,
                                QVector<ExtraSourceFrame> &extras);
+    // Load one extra source's fields aligned to the primary frame. Returns
+    // false if the source has no usable frame there.
+    bool loadExtraSourceFrame(ExtraSource &src, qint32 primarySeq, qint32 primaryVbi,
+                              ExtraSourceFrame &esf);
+
+    // Dropout-correct a frame's two fields in place, reusing a cached result
+    // when the frame was corrected recently. videoFrame (0-based) aligns
+    // extra sources; pass -1 when the fields don't form one video frame.
+    // On failure the fields are left uncorrected, nothing is added to stats
+    // and false is returned with lastError set.
+    bool correctFrameFields(int videoFrame, SourceField &firstField,
+                            SourceField &secondField,
+                            DropoutCorrectionStats *stats);
 };
 
 #endif // TBCREADER_H
@@ -0,0 +1,320 @@
+/******************************************************************************
+ * thumbnailindex.cpp
+ * vapoursynth-analog - Low-resolution thumbnail index of a TBC
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "thumbnailindex.h"
+#include "analog4fsc.h"
+#include "pipefieldsource.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <QDebug>
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = { 'V', 'S', 'A', 'T', 'H', 'M', 'B', '1' };
+
+// Header of a .thumbs file, followed by the thumbnails back to back. The
+// TBC's size and modification time tie the file to the capture it indexes.
+struct CacheHeader {
+    char magic[8];
+    int64_t tbcSize;
+    int64_t tbcModified;
+    int32_t interval;
+    int32_t width;
+    int32_t height;
+    int32_t numThumbnails;
+};
+
+bool tbcIdentity(const std::filesystem::path &path, int64_t &size, int64_t &modified) {
+    std::error_code ec;
+    size = static_cast<int64_t>(std::filesystem::file_size(path, ec));
+    if (ec) return false;
+    modified = static_cast<int64_t>(
+        std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+} // anonymous namespace
+
+ThumbnailIndex::ThumbnailIndex(const std::filesystem::path &tbcPath, const ThumbnailOptions &opts)
+    : tbcPath(tbcPath)
+    , interval(opts.interval)
+{
+    if (opts.interval < 1) {
+        throw VSAnalogException("interval must be at least 1");
+    }
+    if (isPipeInput(tbcPath)) {
+        throw VSAnalogException("Thumbnails need a TBC file, not a pipe");
+    }
+
+    // Only raw fields are read; the mono decoder is the cheapest to set up
+    TbcReader::Configuration config;
+    config.decoder = TbcReader::DecoderType::Mono;
+    config.paddingMultiple = 0;
+    config.metadataPath = opts.metadataPath;
+
+    reader = std::make_unique<TbcReader>();
+    if (!reader->open(tbcPath, config)) {
+        throw VSAnalogException("Failed to open TBC file: " + reader->getLastError().toStdString());
+    }
+
+    const LdDecodeMetaData::VideoParameters &vp = reader->getVideoParameters();
+    sourceStart = vp.activeVideoStart;
+    sourceEnd = vp.activeVideoEnd;
+    firstLine = vp.firstActiveFieldLine;
+    lastLine = vp.lastActiveFieldLine;
+    black = vp.black16bIre;
+    white = vp.white16bIre;
+    if (sourceEnd <= sourceStart || lastLine <= firstLine || white <= black) {
+        throw VSAnalogException("The metadata has no usable active area or video levels");
+    }
+
+    // At least 4 samples per column, so every column spans a subcarrier cycle
+    const int maxWidth = (sourceEnd - sourceStart) / 4;
+    if (opts.width < 8 || opts.width > maxWidth) {
+        throw VSAnalogException("width must be between 8 and " + std::to_string(maxWidth));
+    }
+    width = opts.width;
+    height = std::max(1, static_cast<int>(std::lround(
+        width * (reader->isWidescreen() ? 9.0 / 16.0 : 3.0 / 4.0))));
+    height = std::min(height, lastLine - firstLine);
+
+    numThumbnails = (reader->getNumSourceFrames() + interval - 1) / interval;
+    if (numThumbnails < 1) {
+        throw VSAnalogException("The TBC has no frames");
+    }
+    pixels.resize(static_cast<size_t>(numThumbnails) * width * height);
+    states = std::make_unique<std::atomic<uint8_t>[]>(numThumbnails);
+    for (int i = 0; i < numThumbnails; i++) {
+        states[i].store(PENDING, std::memory_order_relaxed);
+    }
+
+    // Named after the TBC rather than the sidecar, which the TBCs of a
+    // capture (luma and chroma) can share
+    if (opts.cache) {
+        cachePath = tbcPath;
+        cachePath.replace_extension(".thumbs");
+        loadedFromCache = loadCache();
+    }
+    if (loadedFromCache) return;
+
+    // Build on the spare cores, leaving one for whatever displays them
+    int numThreads = opts.threads > 0
+        ? opts.threads
+        : static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    numThreads = std::clamp(numThreads, 1, numThumbnails);
+    for (int i = 0; i < numThreads; i++) {
+        std::unique_ptr<TbcReader> context = reader->createDecodeContext();
+        if (!context) {
+            throw VSAnalogException("Failed to open TBC file: " +
+                                    reader->getLastError().toStdString());
+        }
+        workerReaders.push_back(std::move(context));
+    }
+    for (auto &workerReader : workerReaders) {
+        workers.emplace_back(&ThumbnailIndex::runWorker, this, std::ref(*workerReader));
+    }
+}
+
+ThumbnailIndex::~ThumbnailIndex() {
+    stopping = true;
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+TbcReader::FrameRate ThumbnailIndex::getFrameRate() const {
+    TbcReader::FrameRate rate = reader->getFrameRate();
+    rate.den *= interval;
+    return rate;
+}
+
+void ThumbnailIndex::buildThumbnail(TbcReader &source, int index, SourceVideo::Data &field,
+                                    std::vector<float> &row, std::vector<double> &sums) {
+    if (!source.loadFirstField(index * interval, field)) {
+        throw VSAnalogException("Failed to read frame " + std::to_string(index * interval) +
+                                ": " + source.getLastError().toStdString());
+    }
+
+    const int fieldWidth = source.getFieldWidth();
+    const int sourceWidth = sourceEnd - sourceStart;
+    const int sourceLines = lastLine - firstLine;
+    row.resize(sourceWidth);
+    uint8_t *out = pixels.data() + static_cast<size_t>(index) * width * height;
+
+    for (int y = 0; y < height; y++) {
+        const int lineStart = firstLine + y * sourceLines / height;
+        const int lineEnd = std::max(lineStart + 1, firstLine + (y + 1) * sourceLines / height);
+        sums.assign(width, 0.0);
+
+        for (int line = lineStart; line < lineEnd; line++) {
+            const quint16 *samples = field.data() + static_cast<ptrdiff_t>(line) * fieldWidth;
+
+            // A 4-sample moving average nulls the 4fsc subcarrier
+            for (int x = 0; x < sourceWidth; x++) {
+                const int s = sourceStart + x;
+                row[x] = 0.25f * (static_cast<float>(samples[std::max(s - 1, 0)]) + samples[s] +
+                                  samples[std::min(s + 1, fieldWidth - 1)] +
+                                  samples[std::min(s + 2, fieldWidth - 1)]);
+            }
+            for (int x = 0; x < width; x++) {
+                const int columnStart = x * sourceWidth / width;
+                const int columnEnd = (x + 1) * sourceWidth / width;
+                double sum = 0.0;
+                for (int c = columnStart; c < columnEnd; c++) sum += row[c];
+                sums[x] += sum;
+            }
+        }
+
+        const double lines = lineEnd - lineStart;
+        for (int x = 0; x < width; x++) {
+            const int columns = (x + 1) * sourceWidth / width - x * sourceWidth / width;
+            const double level = (sums[x] / (lines * columns) - black) / (white - black);
+            out[y * width + x] = static_cast<uint8_t>(
+                std::clamp(std::lround(16.0 + 219.0 * level), 0L, 255L));
+        }
+    }
+}
+
+void ThumbnailIndex::markDone(int index) {
+    states[index].store(DONE);
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+    }
+    thumbnailDone.notify_all();
+
+    if (++numDone == numThumbnails && !cachePath.empty()) {
+        saveCache();
+    }
+}
+
+void ThumbnailIndex::runWorker(TbcReader &source) {
+    SourceVideo::Data field;
+    std::vector<float> row;
+    std::vector<double> sums;
+
+    for (int index = nextIndex++; index < numThumbnails && !stopping; index = nextIndex++) {
+        uint8_t expected = PENDING;
+        if (!states[index].compare_exchange_strong(expected, BUILDING)) continue;
+
+        try {
+            buildThumbnail(source, index, field, row, sums);
+        } catch (const std::exception &e) {
+            // Leave the rest to getThumbnail(), which reports its own failures
+            {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                states[index].store(PENDING);
+            }
+            thumbnailDone.notify_all();
+            qWarning() << "Thumbnail worker stopped:" << e.what();
+            return;
+        }
+        markDone(index);
+    }
+}
+
+void ThumbnailIndex::getThumbnail(int index, uint8_t *dst, ptrdiff_t stride) {
+    if (index < 0 || index >= numThumbnails) {
+        throw VSAnalogException("Thumbnail number out of range");
+    }
+
+    for (;;) {
+        uint8_t state = states[index].load();
+        if (state == DONE) break;
+
+        if (state == PENDING && states[index].compare_exchange_strong(state, BUILDING)) {
+            // The workers haven't reached it; build it here
+            try {
+                std::lock_guard<std::mutex> lock(readerMutex);
+                buildThumbnail(*reader, index, readerField, readerRow, readerSums);
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    states[index].store(PENDING);
+                }
+                thumbnailDone.notify_all();
+                throw;
+            }
+            markDone(index);
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        thumbnailDone.wait(lock, [&]() { return states[index].load() != BUILDING; });
+    }
+
+    const uint8_t *src = pixels.data() + static_cast<size_t>(index) * width * height;
+    for (int y = 0; y < height; y++) {
+        std::memcpy(dst + y * stride, src + y * width, width);
+    }
+}
+
+bool ThumbnailIndex::loadCache() {
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in) return false;
+
+    CacheHeader header;
+    int64_t tbcSize, tbcModified;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        !tbcIdentity(tbcPath, tbcSize, tbcModified) ||
+        header.tbcSize != tbcSize || header.tbcModified != tbcModified ||
+        header.interval != interval || header.width != width || header.height != height ||
+        header.numThumbnails != numThumbnails) {
+        return false;
+    }
+    if (!in.read(reinterpret_cast<char *>(pixels.data()),
+                 static_cast<std::streamsize>(pixels.size()))) {
+        return false;
+    }
+
+    for (int i = 0; i < numThumbnails; i++) {
+        states[i].store(DONE, std::memory_order_relaxed);
+    }
+    numDone = numThumbnails;
+    return true;
+}
+
+void ThumbnailIndex::saveCache() const {
+    CacheHeader header = {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    if (!tbcIdentity(tbcPath, header.tbcSize, header.tbcModified)) return;
+    header.interval = interval;
+    header.width = width;
+    header.height = height;
+    header.numThumbnails = numThumbnails;
+
+    // Write aside and rename, so other processes never read a partial index.
+    // Failing to save (e.g. read-only media) only costs the next open a rebuild.
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(pixels.data()),
+                  static_cast<std::streamsize>(pixels.size()));
+        if (!out) {
+            qWarning() << "Failed to save thumbnail index:"
+                       << QString::fromStdString(cachePath.string());
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        qWarning() << "Failed to save thumbnail index:"
+                   << QString::fromStdString(cachePath.string()) << ec.message().c_str();
+        std::filesystem::remove(tempPath, ec);
+    }
+}
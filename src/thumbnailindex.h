@@ -0,0 +1,105 @@
+/******************************************************************************
+ * thumbnailindex.h
+ * vapoursynth-analog - Low-resolution thumbnail index of a TBC
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef THUMBNAILINDEX_H
+#define THUMBNAILINDEX_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tbcreader.h"
+
+struct ThumbnailOptions {
+    int interval = 120;  // Video frames per thumbnail
+    int width = 128;     // Thumbnail width in pixels
+    int threads = 0;     // Background workers (0 = one less than the hardware threads)
+    bool cache = true;   // Load and save the index next to the TBC
+    // Metadata sidecar (.db or .json) to use instead of looking next to the TBC
+    std::filesystem::path metadataPath;
+};
+
+// Thumbnails of every interval-th video frame of a TBC, for a quick visual
+// overview of long captures. Each is the first field's luma, low-passed at
+// the subcarrier frequency and area-averaged down to a few thousand samples,
+// without chroma decoding or dropout correction.
+//
+// Thumbnails are built by background workers from the moment the index is
+// opened; one requested before the workers reach it is built on the calling
+// thread. Once complete, the index is saved next to the TBC (<TBC
+// base>.thumbs) so later opens of an unchanged TBC skip the build.
+class ThumbnailIndex {
+public:
+    // Open the TBC and start building any thumbnails the cache file lacks.
+    // Throws VSAnalogException on failure.
+    ThumbnailIndex(const std::filesystem::path &tbcPath, const ThumbnailOptions &opts);
+    ~ThumbnailIndex();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getNumThumbnails() const { return numThumbnails; }
+    int getInterval() const { return interval; }
+    TbcReader::FrameRate getFrameRate() const;  // Video frame rate over the interval
+    bool isCached() const { return loadedFromCache; }
+
+    // Copy thumbnail index (width x height 8-bit luma, limited range) into
+    // dst, stride bytes per row. Throws VSAnalogException if the TBC can't be
+    // read.
+    void getThumbnail(int index, uint8_t *dst, ptrdiff_t stride);
+
+private:
+    enum : uint8_t { PENDING, BUILDING, DONE };
+
+    // Builds thumbnails for getThumbnail(), with its buffers
+    std::unique_ptr<TbcReader> reader;
+    std::mutex readerMutex;
+    SourceVideo::Data readerField;
+    std::vector<float> readerRow;
+    std::vector<double> readerSums;
+
+    std::filesystem::path tbcPath;
+    std::filesystem::path cachePath;    // Empty when not caching
+    int interval;
+    int width = 0;
+    int height = 0;
+    int numThumbnails = 0;
+    bool loadedFromCache = false;
+
+    // Source area in field samples/lines and its black/white levels
+    int sourceStart = 0;
+    int sourceEnd = 0;
+    int firstLine = 0;
+    int lastLine = 0;
+    double black = 0.0;
+    double white = 0.0;
+
+    std::vector<uint8_t> pixels;  // Every thumbnail, back to back
+    std::unique_ptr<std::atomic<uint8_t>[]> states;
+    std::atomic<int> nextIndex{0};
+    std::atomic<int> numDone{0};
+    std::atomic<bool> stopping{false};
+    std::mutex doneMutex;
+    std::condition_variable thumbnailDone;
+
+    std::vector<std::unique_ptr<TbcReader>> workerReaders;
+    std::vector<std::thread> workers;
+
+    void buildThumbnail(TbcReader &source, int index, SourceVideo::Data &field,
+                        std::vector<float> &row, std::vector<double> &sums);
+    void markDone(int index);
+    void runWorker(TbcReader &source);
+
+    bool loadCache();
+    void saveCache() const;
+};
+
+#endif // THUMBNAILINDEX_H
@@ -0,0 +1,58 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Shared setup of the plugin tests.
+
+The tests load the plugin built by meson (passed in ``VSANALOG_PLUGIN``), or
+the installed one when that isn't set, and are skipped where VapourSynth's
+Python module isn't available.
+"""
+
+from __future__ import annotations
+
+import os
+import tempfile
+import unittest
+from pathlib import Path
+from typing import Any
+
+try:
+    import vapoursynth as vs
+except ImportError:  # pragma: no cover - depends on the environment
+    vs = None
+
+
+def load_core() -> Any:
+    """Return the VapourSynth core with the plugin loaded."""
+    if vs is None:
+        raise unittest.SkipTest("VapourSynth's Python module is not installed")
+    core = vs.core
+    if not hasattr(core, "analog"):
+        plugin = os.environ.get("VSANALOG_PLUGIN")
+        if not plugin:
+            raise unittest.SkipTest("VSANALOG_PLUGIN is not set and the plugin isn't installed")
+        core.std.LoadPlugin(plugin)
+    return core
+
+
+def frame_contents(frame: Any) -> tuple[list[bytes], dict[str, Any]]:
+    """The planes and properties of a frame, for comparing decodes."""
+    planes = [
+        memoryview(frame[plane]).tobytes() for plane in range(frame.format.num_planes)
+    ]
+    props = {
+        key: (list(value) if isinstance(value, (list, tuple)) else value)
+        for key, value in frame.props.items()
+    }
+    return planes, props
+
+
+class CaptureTestCase(unittest.TestCase):
+    """Test case with the plugin loaded and a scratch directory."""
+
+    core: Any
+    directory: Path
+
+    def setUp(self) -> None:
+        self.core = load_core()
+        scratch = tempfile.TemporaryDirectory(prefix="vsanalog-test-")
+        self.addCleanup(scratch.cleanup)
+        self.directory = Path(scratch.name)
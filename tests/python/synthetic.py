@@ -0,0 +1,220 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Small synthetic NTSC (or PAL) captures for the plugin tests.
+
+Writes a 4𝑓𝑠𝑐 TBC of a few frames and a SQLite metadata sidecar with the
+tables and columns the plugin reads. The picture has sync, a colour burst,
+colour bars, a gradient and a box that moves between frames, plus a little
+noise, so the 2D and 3D decoders, dropout correction and motion detection
+all have something to work on. Everything comes from a seeded generator,
+so the same arguments always write the same files.
+"""
+
+from __future__ import annotations
+
+import array
+import functools
+import math
+import operator
+import random
+import sqlite3
+import sys
+from pathlib import Path
+from typing import NamedTuple
+
+
+class Geometry(NamedTuple):
+    """Field layout of a video system, as the sidecar describes it."""
+
+    system: str
+    sample_rate: float
+    field_width: int
+    field_height: int
+    active_video_start: int
+    active_video_end: int
+    colour_burst_start: int
+    colour_burst_end: int
+
+
+NTSC = Geometry("NTSC", 4 * 315.0e6 / 88.0, 910, 263, 134, 894, 78, 110)
+# The PAL picture reuses the NTSC one's four-sample subcarrier, which is
+# enough for comparing decodes with each other
+PAL = Geometry("PAL", 4 * 4433618.75, 1135, 313, 185, 1107, 98, 138)
+
+WHITE_16B_IRE = 51200
+BLACK_16B_IRE = 18048
+
+# Dropouts written into the samples and listed in the sidecar, as
+# (field index, 0-based field line, startx, endx)
+DROPOUTS = [(3, 100, 400, 440), (10, 150, 600, 650)]
+
+_IRE = (WHITE_16B_IRE - BLACK_16B_IRE) / 100.0
+
+# Maps random bytes to noise in [0, 32)
+_NOISE_BITS = bytes(n & 31 for n in range(256))
+
+# Colour bars as (luma IRE, chroma amplitude IRE, phase in degrees)
+_BARS = [
+    (77, 0, 0),
+    (69, 31, 167),
+    (56, 44, 283),
+    (48, 41, 241),
+    (36, 41, 61),
+    (28, 44, 103),
+    (15, 31, 347),
+]
+
+
+def _level(ire: float) -> int:
+    return max(0, min(65535, round(BLACK_16B_IRE + ire * _IRE)))
+
+
+@functools.lru_cache(maxsize=None)
+def _line_template(
+    line: int, frame: int, global_offset: int, geometry: Geometry
+) -> tuple[int, ...]:
+    """Samples of one field line before noise (biased by -16, see below).
+
+    Only the offset modulo 4 affects the subcarrier, so callers pass that.
+    """
+    samples = [_level(0)] * geometry.field_width
+    for x in range(66):
+        samples[x] = _level(-40)
+    if line < 9:
+        # Vertical blanking: sync and blanking only
+        return tuple(level - 16 for level in samples)
+
+    def subcarrier(x: int, amplitude: float, phase: float) -> float:
+        # Four samples per subcarrier cycle; the phase runs on across lines
+        angle = math.pi / 2 * ((global_offset + x) % 4) + math.radians(phase)
+        return amplitude * math.sin(angle)
+
+    for x in range(geometry.colour_burst_start, geometry.colour_burst_end):
+        samples[x] = _level(subcarrier(x, 20, 180))
+
+    start, end = geometry.active_video_start, geometry.active_video_end
+    box_left = start + 100 + 24 * frame
+    for x in range(start, end):
+        position = (x - start) / (end - start)
+        if 30 <= line < 80:
+            luma, amplitude, phase = _BARS[min(int(position * len(_BARS)), len(_BARS) - 1)]
+            samples[x] = _level(luma + subcarrier(x, amplitude, phase))
+        elif 100 <= line < 180 and box_left <= x < box_left + 120:
+            samples[x] = _level(90 + subcarrier(x, 15, 100))
+        else:
+            samples[x] = _level(10 + 60 * position)
+    # Noise is added as a byte in [0, 32) to these, centring it on the level
+    return tuple(level - 16 for level in samples)
+
+
+def write_capture(
+    directory: Path,
+    name: str = "capture",
+    *,
+    frames: int = 8,
+    seed: int = 1,
+    sidecar: bool = True,
+    picture_numbers: list[int] | None = None,
+    geometry: Geometry = NTSC,
+    moving: bool = True,
+) -> Path:
+    """Write ``<name>.tbc`` (and unless *sidecar* is false, ``<name>.db``).
+
+    *picture_numbers* gives each frame a CAV picture number in the VBI of its
+    first field, as a film-sourced laserdisc would carry. Unless *moving*, the
+    box stays put and only the noise changes between frames.
+
+    Returns the TBC path.
+    """
+    rng = random.Random(seed)
+    fields = 2 * frames
+    tbc_path = directory / f"{name}.tbc"
+    dropouts = {(field, line): (startx, endx) for field, line, startx, endx in DROPOUTS}
+    with open(tbc_path, "wb") as tbc:
+        for field in range(fields):
+            frame = field // 2
+            samples = array.array("H")
+            for line in range(geometry.field_height):
+                offset = (field * geometry.field_height + line) * geometry.field_width
+                template = _line_template(line, frame if moving else 0, offset % 4, geometry)
+                # Levels stay well inside the 16-bit range, so need no clamping
+                noise = rng.randbytes(geometry.field_width).translate(_NOISE_BITS)
+                row = array.array("H", map(operator.add, template, noise))
+                if (field, line) in dropouts:
+                    startx, endx = dropouts[(field, line)]
+                    row[startx:endx] = array.array("H", [_level(-35)] * (endx - startx))
+                samples.extend(row)
+            if sys.byteorder != "little":
+                samples.byteswap()
+            tbc.write(samples.tobytes())
+
+    if sidecar:
+        write_sidecar(directory / f"{name}.db", fields, picture_numbers, geometry)
+    return tbc_path
+
+
+def picture_number_code(picture_number: int) -> int:
+    """VBI line 17/18 code of a CAV picture number: 0xF then five BCD digits."""
+    return 0xF00000 | int(f"{picture_number:05d}", 16)
+
+
+def write_sidecar(
+    db_path: Path,
+    fields: int,
+    picture_numbers: list[int] | None = None,
+    geometry: Geometry = NTSC,
+) -> None:
+    """Write the metadata of a capture written by :func:`write_capture`."""
+    db_path.unlink(missing_ok=True)
+    with sqlite3.connect(db_path) as db:
+        db.executescript(
+            """
+            CREATE TABLE capture (
+                capture_id INTEGER PRIMARY KEY, system TEXT,
+                video_sample_rate REAL, field_width INTEGER, field_height INTEGER,
+                active_video_start INTEGER, active_video_end INTEGER,
+                colour_burst_start INTEGER, colour_burst_end INTEGER,
+                white_16b_ire INTEGER, black_16b_ire INTEGER,
+                is_subcarrier_locked INTEGER, is_widescreen INTEGER,
+                number_of_sequential_fields INTEGER);
+            CREATE TABLE field_record (
+                capture_id INTEGER, field_id INTEGER, is_first_field INTEGER,
+                sync_conf INTEGER, median_burst_ire REAL, field_phase_id INTEGER,
+                audio_samples INTEGER, disk_loc REAL, file_loc INTEGER,
+                decode_faults INTEGER, pad INTEGER);
+            CREATE TABLE drop_outs (
+                capture_id INTEGER, field_id INTEGER, field_line INTEGER,
+                startx INTEGER, endx INTEGER);
+            """
+        )
+        db.execute(
+            "INSERT INTO capture VALUES (1, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, 0, 0, ?)",
+            (*geometry, WHITE_16B_IRE, BLACK_16B_IRE, fields),
+        )
+        db.executemany(
+            "INSERT INTO field_record VALUES (1, ?, ?, 100, 20.0, ?, NULL, NULL, NULL, 0, 0)",
+            [(field, int(field % 2 == 0), field % 4 + 1) for field in range(fields)],
+        )
+        # Field lines are 1-based in the metadata
+        db.executemany(
+            "INSERT INTO drop_outs VALUES (1, ?, ?, ?, ?)",
+            [
+                (field, line + 1, startx, endx)
+                for field, line, startx, endx in DROPOUTS
+                if field < fields
+            ],
+        )
+        if picture_numbers is not None:
+            db.execute(
+                "CREATE TABLE vbi (capture_id INTEGER, field_id INTEGER,"
+                " vbi0 INTEGER, vbi1 INTEGER, vbi2 INTEGER)"
+            )
+            # Second fields carry no picture number
+            codes = [picture_number_code(number) for number in picture_numbers]
+            db.executemany(
+                "INSERT INTO vbi VALUES (1, ?, 0, ?, ?)",
+                [
+                    (field, code, code)
+                    for field in range(fields)
+                    for code in [codes[field // 2] if field % 2 == 0 else 0]
+                ],
+            )
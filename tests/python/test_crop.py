@@ -0,0 +1,53 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Cropped decodes match the same crop of a full decode, for every decoder."""
+
+from __future__ import annotations
+
+import unittest
+from typing import Any
+
+from plugintest import CaptureTestCase
+from synthetic import NTSC, PAL, write_capture
+
+# Decoders by the system of the capture they decode
+DECODERS = {
+    NTSC: ["ntsc1d", "ntsc2d", "ntsc3d", "ntsc3dnoadapt", "mono"],
+    PAL: ["pal2d", "transform2d", "transform3d"],
+}
+
+# Odd amounts, so the kept area is aligned to neither the subcarrier, the
+# field lines nor the Transform PAL tiles
+CROP = {"crop_left": 45, "crop_top": 31, "crop_right": 63, "crop_bottom": 27}
+
+
+def planes(frame: Any) -> list[list[list[Any]]]:
+    return [memoryview(frame[plane]).tolist() for plane in range(frame.format.num_planes)]
+
+
+class CropTest(CaptureTestCase):
+    def test_cropped_decodes_match_full_decodes(self) -> None:
+        for geometry, decoders in DECODERS.items():
+            tbc = str(write_capture(self.directory, geometry.system, frames=6, geometry=geometry))
+            for decoder in decoders:
+                with self.subTest(system=geometry.system, decoder=decoder):
+                    full = self.core.analog.decode_4fsc_video(
+                        tbc, decoder=decoder, padding_multiple=0)
+                    cropped = self.core.analog.decode_4fsc_video(
+                        tbc, decoder=decoder, padding_multiple=0, **CROP)
+                    self.assertEqual(
+                        cropped.width, full.width - CROP["crop_left"] - CROP["crop_right"])
+                    self.assertEqual(
+                        cropped.height, full.height - CROP["crop_top"] - CROP["crop_bottom"])
+
+                    # Frames with neighbours on both sides for the 3D decoders
+                    for n in range(1, 5):
+                        expected = [
+                            [row[CROP["crop_left"]:CROP["crop_left"] + cropped.width]
+                             for row in plane[CROP["crop_top"]:CROP["crop_top"] + cropped.height]]
+                            for plane in planes(full.get_frame(n))
+                        ]
+                        self.assertEqual(planes(cropped.get_frame(n)), expected, f"frame {n}")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,75 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Opening captures with decode_many, in a plain process and under vspipe."""
+
+from __future__ import annotations
+
+import importlib.util
+import os
+import shutil
+import subprocess
+import unittest
+
+from plugintest import CaptureTestCase
+from synthetic import write_capture
+
+# Evaluated by vspipe in a script environment, as vspipe, vsscript users and
+# vspreview evaluate scripts. decode_many opens the clips on worker threads,
+# which must use this script's core.
+SCRIPT = """\
+import vapoursynth as vs
+
+if not hasattr(vs.core, "analog") and plugin:
+    vs.core.std.LoadPlugin(plugin)
+
+from vsanalog import decode_many
+
+clips = decode_many([first, second], max_workers=2)
+for index, clip in enumerate(clips):
+    clip.set_output(index)
+"""
+
+
+def vsanalog_installed() -> bool:
+    try:
+        return importlib.util.find_spec("vsanalog") is not None
+    except ImportError:  # pragma: no cover - depends on the environment
+        return False
+
+
+@unittest.skipUnless(vsanalog_installed(), "the vsanalog package is not installed")
+class DecodeManyTest(CaptureTestCase):
+    def setUp(self) -> None:
+        super().setUp()
+        self.first = write_capture(self.directory, "first", frames=4, seed=1)
+        self.second = write_capture(self.directory, "second", frames=6, seed=2)
+
+    def test_clips_in_source_order(self) -> None:
+        from vsanalog import decode_many
+
+        clips = decode_many([self.first, self.second], max_workers=2)
+        self.assertEqual([clip.num_frames for clip in clips], [4, 6])
+
+    @unittest.skipUnless(shutil.which("vspipe"), "vspipe is not installed")
+    def test_under_vspipe(self) -> None:
+        script = self.directory / "decode_many.vpy"
+        script.write_text(SCRIPT)
+        for index, frames in enumerate([4, 6]):
+            result = subprocess.run(
+                [
+                    "vspipe", "--info",
+                    "--outputindex", str(index),
+                    "--arg", f"first={self.first}",
+                    "--arg", f"second={self.second}",
+                    "--arg", f"plugin={os.environ.get('VSANALOG_PLUGIN', '')}",
+                    str(script), "-",
+                ],
+                capture_output=True,
+                text=True,
+                timeout=120,
+            )
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertRegex(result.stdout, rf"Frames:\s*{frames}\b")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,55 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""motion_skip leaves static areas as the 3D decoders decode them."""
+
+from __future__ import annotations
+
+import unittest
+from typing import Any
+
+from plugintest import CaptureTestCase
+from synthetic import NTSC, PAL, write_capture
+
+DECODERS = {NTSC: "ntsc3d", PAL: "transform3d"}
+
+# Low enough that the moving box switches its bands to 2D
+THRESHOLD = 0.02
+
+# Output rows of the bars above the box, all inside the first band
+STATIC_ROWS = 50
+
+
+def planes(frame: Any) -> list[list[list[Any]]]:
+    return [memoryview(frame[plane]).tolist() for plane in range(frame.format.num_planes)]
+
+
+class MotionSkipTest(CaptureTestCase):
+    def decode_pair(self, tbc: str, decoder: str) -> tuple[Any, Any]:
+        plain = self.core.analog.decode_4fsc_video(tbc, decoder=decoder)
+        skipping = self.core.analog.decode_4fsc_video(
+            tbc, decoder=decoder, motion_skip=THRESHOLD)
+        return plain, skipping
+
+    def test_static_content_matches_3d_decode(self) -> None:
+        for geometry, decoder in DECODERS.items():
+            tbc = str(write_capture(
+                self.directory, f"static_{geometry.system}", frames=4,
+                geometry=geometry, moving=False))
+            plain, skipping = self.decode_pair(tbc, decoder)
+            for n in range(plain.num_frames):
+                with self.subTest(decoder=decoder, frame=n):
+                    self.assertEqual(planes(skipping.get_frame(n)), planes(plain.get_frame(n)))
+
+    def test_static_bands_match_3d_decode(self) -> None:
+        for geometry, decoder in DECODERS.items():
+            tbc = str(write_capture(
+                self.directory, f"moving_{geometry.system}", frames=4, geometry=geometry))
+            plain, skipping = self.decode_pair(tbc, decoder)
+            for n in range(1, plain.num_frames):
+                with self.subTest(decoder=decoder, frame=n):
+                    expected = [plane[:STATIC_ROWS] for plane in planes(plain.get_frame(n))]
+                    decoded = [plane[:STATIC_ROWS] for plane in planes(skipping.get_frame(n))]
+                    self.assertEqual(decoded, expected)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,83 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Frames decoded by several decode contexts match a single-threaded decode."""
+
+from __future__ import annotations
+
+import os
+import random
+import shutil
+import sys
+import unittest
+from typing import Any
+from unittest import mock
+
+from plugintest import CaptureTestCase, frame_contents
+from synthetic import write_capture
+
+# Decodes compared, as decode_4fsc_video options besides the source
+CASES: list[dict[str, Any]] = [
+    {"decoder": "ntsc2d"},
+    {"decoder": "ntsc3d"},
+    {"decoder": "ntsc3d", "dropout_correct": 1},
+    # Cached sources keep corrected frames, shared by the decode contexts
+    {"decoder": "ntsc3d", "dropout_correct": 1, "cache": 1},
+    {"decoder": "ntsc2d", "dropout_correct": 1, "dropout_detect": 2},
+    # AnalogLumaDiff compares with the previous frame, whatever was decoded
+    {"decoder": "ntsc3d", "frame_metrics": 1},
+    {"decoder": "ntsc2d", "frame_metrics": 1, "field_output": 1},
+]
+
+
+class ParallelDeterminismTest(CaptureTestCase):
+    def decode_all(self, clip: Any, order: list[int]) -> list[tuple[int, Any]]:
+        """Request every frame in *order* at once and gather their contents."""
+        futures = [(n, clip.get_frame_async(n)) for n in order]
+        return [(n, frame_contents(future.result())) for n, future in futures]
+
+    def assert_decodes_match(self, tbc: str, threads: int, **opts: Any) -> None:
+        reference = self.core.analog.decode_4fsc_video(tbc, threads=1, **opts)
+        expected = {n: frame_contents(reference.get_frame(n)) for n in range(reference.num_frames)}
+
+        clip = self.core.analog.decode_4fsc_video(tbc, threads=threads, **opts)
+        # Every frame twice, in shuffled order, so frames are decoded out of
+        # order and some by two contexts at once
+        order = list(range(clip.num_frames)) * 2
+        random.Random(threads).shuffle(order)
+        for n, contents in self.decode_all(clip, order):
+            self.assertEqual(contents, expected[n], f"frame {n}")
+
+    def test_threads_match_single_thread(self) -> None:
+        tbc = str(write_capture(self.directory))
+        for opts in CASES:
+            with self.subTest(**opts):
+                self.assert_decodes_match(tbc, 4, **opts)
+
+    @unittest.skipUnless(sys.platform.startswith("linux"), "the cache directory is set by XDG_CACHE_HOME")
+    def test_calibrated_threads_match_single_thread(self) -> None:
+        tbc = str(write_capture(self.directory))
+        # threads=-1 measures the host once per setup and keeps the result in
+        # the user's cache directory, kept here in the scratch directory
+        cache = self.directory / "cache"
+        with mock.patch.dict(os.environ, {"XDG_CACHE_HOME": str(cache)}):
+            for opts in CASES[:2]:
+                with self.subTest(**opts):
+                    self.assert_decodes_match(tbc, -1, **opts)
+                    # Opened again from the stored calibration
+                    self.assert_decodes_match(tbc, -1, **opts)
+        self.assertTrue((cache / "vsanalog" / "autotune.ini").exists())
+
+    def test_extra_sources_match_single_thread(self) -> None:
+        tbc = str(write_capture(self.directory))
+        extra = write_capture(self.directory, "extra", seed=2, sidecar=False)
+        shutil.copyfile(self.directory / "capture.db", self.directory / "extra.db")
+        self.assert_decodes_match(
+            tbc,
+            4,
+            decoder="ntsc3d",
+            dropout_correct=1,
+            dropout_composite_or_luma_extra_sources=[str(extra)],
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,60 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Decoding a TBC streamed through a FIFO."""
+
+from __future__ import annotations
+
+import os
+import shutil
+import threading
+import unittest
+
+from plugintest import CaptureTestCase, frame_contents
+from synthetic import write_capture
+
+
+@unittest.skipUnless(hasattr(os, "mkfifo"), "FIFOs need a POSIX system")
+class PipeInputTest(CaptureTestCase):
+    def test_fifo_matches_file(self) -> None:
+        tbc = write_capture(self.directory)
+        fifo = self.directory / "piped.tbc"
+        os.mkfifo(fifo)
+        shutil.copyfile(self.directory / "capture.db", self.directory / "piped.db")
+
+        def feed() -> None:
+            # Blocks until the source opens the FIFO for reading
+            with open(fifo, "wb") as pipe, open(tbc, "rb") as source:
+                shutil.copyfileobj(source, pipe)
+
+        feeder = threading.Thread(target=feed, daemon=True)
+        feeder.start()
+
+        opts = {"decoder": "ntsc3d", "dropout_correct": 1}
+        piped = self.core.analog.decode_4fsc_video(str(fifo), **opts)
+        from_file = self.core.analog.decode_4fsc_video(str(tbc), **opts)
+        self.assertEqual(piped.num_frames, from_file.num_frames)
+
+        # Frames are requested in order, as pipe input requires
+        for n in range(piped.num_frames):
+            self.assertEqual(
+                frame_contents(piped.get_frame(n)),
+                frame_contents(from_file.get_frame(n)),
+                f"frame {n}",
+            )
+        feeder.join(timeout=10)
+        self.assertFalse(feeder.is_alive())
+
+    def test_extra_sources_must_be_files(self) -> None:
+        tbc = write_capture(self.directory)
+        fifo = self.directory / "extra.tbc"
+        os.mkfifo(fifo)
+        shutil.copyfile(self.directory / "capture.db", self.directory / "extra.db")
+        with self.assertRaisesRegex(Exception, "pipes"):
+            self.core.analog.decode_4fsc_video(
+                str(tbc),
+                dropout_correct=1,
+                dropout_composite_or_luma_extra_sources=[str(fifo)],
+            )
+
+
+if __name__ == "__main__":
+    unittest.main()
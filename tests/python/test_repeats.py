@@ -0,0 +1,74 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Repeated pictures served from one decode (reuse_repeats)."""
+
+from __future__ import annotations
+
+import unittest
+from typing import Any
+
+from plugintest import CaptureTestCase, frame_contents
+from synthetic import write_capture
+
+# A held picture over frames 1-3 and another over frames 5-6
+PICTURE_NUMBERS = [1, 2, 2, 2, 3, 4, 4, 5]
+# The frame each frame's picture is decoded from
+SOURCES = [0, 1, 1, 1, 4, 5, 5, 7]
+
+
+class RepeatsTest(CaptureTestCase):
+    def decode_all(self, clip: Any) -> list[Any]:
+        """Request every frame at once, so runs are decoded concurrently."""
+        futures = [clip.get_frame_async(n) for n in range(clip.num_frames)]
+        return [future.result() for future in futures]
+
+    def assert_repeats_served(self, field_output: int) -> None:
+        tbc = str(write_capture(self.directory, picture_numbers=PICTURE_NUMBERS))
+        opts = {"decoder": "ntsc2d", "field_output": field_output, "threads": 4}
+        plain = self.core.analog.decode_4fsc_video(tbc, **opts)
+        reused = self.core.analog.decode_4fsc_video(tbc, reuse_repeats=1, **opts)
+        self.assertEqual(reused.num_frames, plain.num_frames)
+
+        expected = [frame_contents(frame) for frame in self.decode_all(plain)]
+        for n, frame in enumerate(self.decode_all(reused)):
+            # Fields repeat the same field of their frame's source frame
+            source = SOURCES[n // 2] * 2 + n % 2 if field_output else SOURCES[n]
+            planes, props = frame_contents(frame)
+            self.assertEqual(planes, expected[source][0], f"frame {n}")
+            if source != n:
+                self.assertEqual(props["AnalogRepeatOf"], source, f"frame {n}")
+            else:
+                self.assertNotIn("AnalogRepeatOf", props, f"frame {n}")
+            self.assertEqual(props["_FieldBased"], expected[n][1]["_FieldBased"])
+            if field_output:
+                self.assertEqual(props["_Field"], expected[n][1]["_Field"])
+
+    def test_frames_repeat_their_run(self) -> None:
+        self.assert_repeats_served(field_output=0)
+
+    def test_fields_repeat_their_run(self) -> None:
+        self.assert_repeats_served(field_output=1)
+
+    def test_repeats_are_unchanged(self) -> None:
+        tbc = str(write_capture(self.directory, picture_numbers=PICTURE_NUMBERS))
+        clip = self.core.analog.decode_4fsc_video(
+            tbc, decoder="ntsc2d", reuse_repeats=1, frame_metrics=1, threads=4)
+        frames = self.decode_all(clip)
+        for n, frame in enumerate(frames):
+            props = frame.props
+            if SOURCES[n] != n:
+                self.assertEqual(props["AnalogLumaDiff"], 0.0, f"frame {n}")
+                source = frames[SOURCES[n]].props
+                for prop in ("AnalogLumaAverage", "AnalogLumaMin", "AnalogLumaMax"):
+                    self.assertEqual(props[prop], source[prop], f"frame {n}")
+            elif n > 0:
+                self.assertGreater(props["AnalogLumaDiff"], 0.0, f"frame {n}")
+
+    def test_separated_fields_are_progressive(self) -> None:
+        tbc = str(write_capture(self.directory, frames=2))
+        clip = self.core.analog.decode_4fsc_video(tbc, field_output=1)
+        for n in range(clip.num_frames):
+            self.assertEqual(clip.get_frame(n).props["_FieldBased"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
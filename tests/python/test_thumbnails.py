@@ -0,0 +1,49 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Thumbnail indexes of the TBCs of a capture, saved and loaded again."""
+
+from __future__ import annotations
+
+import array
+import time
+import unittest
+from pathlib import Path
+from typing import Any
+
+from plugintest import CaptureTestCase, frame_contents
+from synthetic import BLACK_16B_IRE, write_capture
+
+
+class ThumbnailsTest(CaptureTestCase):
+    def thumbnails(self, tbc: Path, **opts: Any) -> list[Any]:
+        clip = self.core.analog.thumbnails(str(tbc), interval=2, threads=1, **opts)
+        return [frame_contents(frame) for frame in clip.frames()]
+
+    def wait_for(self, path: Path) -> None:
+        """Wait for the index saved once the background workers finish."""
+        deadline = time.monotonic() + 60
+        while not path.exists():
+            if time.monotonic() > deadline:
+                self.fail(f"{path.name} was not saved")
+            time.sleep(0.05)
+
+    def test_tbcs_sharing_a_sidecar_keep_their_own_index(self) -> None:
+        luma = write_capture(self.directory)
+        sidecar = self.directory / "capture.db"
+        # The chroma TBC of the same capture, described by the luma's
+        # sidecar: the same size, but flat black
+        chroma = self.directory / "capture_chroma.tbc"
+        samples = luma.stat().st_size // 2
+        chroma.write_bytes(array.array("H", [BLACK_16B_IRE]).tobytes() * samples)
+
+        built_luma = self.thumbnails(luma)
+        built_chroma = self.thumbnails(chroma, metadata=str(sidecar))
+        self.assertNotEqual(built_luma, built_chroma)
+
+        self.wait_for(self.directory / "capture.thumbs")
+        self.wait_for(self.directory / "capture_chroma.thumbs")
+        self.assertEqual(self.thumbnails(luma), built_luma)
+        self.assertEqual(self.thumbnails(chroma, metadata=str(sidecar)), built_chroma)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,130 @@
+/******************************************************************************
+ * test_dropoutdetector.cpp
+ * vapoursynth-analog - Tests of signal-based dropout detection
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "dropoutdetector.cpp"
+
+#include "testing.h"
+#include "testvideo.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+
+// Picture content: a ramp across the line with a little noise, which never
+// leaves the video range or holds one level for a block
+SourceVideo::Data cleanField(const LdDecodeMetaData::VideoParameters &vp, std::mt19937 &rng) {
+    std::uniform_int_distribution<int> noise(-40, 40);
+    SourceVideo::Data field(static_cast<size_t>(vp.fieldWidth) * vp.fieldHeight);
+    const int range = vp.white16bIre - vp.black16bIre;
+    for (qint32 line = 0; line < vp.fieldHeight; line++) {
+        for (qint32 x = 0; x < vp.fieldWidth; x++) {
+            const int level = vp.black16bIre + range * x / vp.fieldWidth + noise(rng);
+            field[static_cast<size_t>(line) * vp.fieldWidth + x] = static_cast<quint16>(level);
+        }
+    }
+    return field;
+}
+
+// Whether one of the regions on 1-based fieldLine covers [startx, endx)
+bool covered(const DropOuts &dropOuts, qint32 fieldLine, qint32 startx, qint32 endx) {
+    for (qint32 i = 0; i < dropOuts.size(); i++) {
+        if (dropOuts.fieldLine(i) == fieldLine && dropOuts.startx(i) <= startx &&
+            dropOuts.endx(i) >= endx) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The vector scanner against the scalar reference, on blocks mixing
+// in-range samples, samples just past either limit and repeated values
+void testScanBlockMatchesScalar() {
+    std::mt19937 rng(20240601);
+    std::uniform_int_distribution<int> anyLevel(0, 65535);
+    std::uniform_int_distribution<int> choice(0, 7);
+    quint16 block[BLOCK + 1];
+    for (int iteration = 0; iteration < 200000; iteration++) {
+        const quint16 low = static_cast<quint16>(anyLevel(rng));
+        const quint16 high = static_cast<quint16>(std::max<int>(low, anyLevel(rng)));
+        for (int i = 0; i <= BLOCK; i++) {
+            switch (choice(rng)) {
+                case 0: block[i] = low; break;
+                case 1: block[i] = high; break;
+                case 2: block[i] = static_cast<quint16>(low == 0 ? 0 : low - 1); break;
+                case 3: block[i] = static_cast<quint16>(high == 65535 ? 65535 : high + 1); break;
+                case 4:
+                case 5: block[i] = i > 0 ? block[i - 1] : low; break;
+                default: block[i] = static_cast<quint16>(anyLevel(rng)); break;
+            }
+        }
+        bool flat = false;
+        bool flatScalar = false;
+        const unsigned outside = scanBlock(block, low, high, flat);
+        const unsigned outsideScalar = scanBlockScalar(block, low, high, flatScalar);
+        CHECK_EQ(outside, outsideScalar);
+        CHECK_EQ(flat, flatScalar);
+        if (testFailures() > 10) return;
+    }
+
+    // Every sample equal, at both ends of the 16-bit range
+    for (const quint16 level : {quint16(0), quint16(32768), quint16(65535)}) {
+        std::fill(block, block + BLOCK + 1, level);
+        bool flat = false;
+        bool flatScalar = false;
+        CHECK_EQ(scanBlock(block, 1, 65534, flat), scanBlockScalar(block, 1, 65534, flatScalar));
+        CHECK(flat && flatScalar);
+    }
+}
+
+// Detection on each field size instantiation (standard NTSC and PAL, and
+// the generic one)
+void testDetectField(qint32 fieldWidth, qint32 fieldHeight) {
+    const LdDecodeMetaData::VideoParameters vp = testParameters(fieldWidth, fieldHeight);
+    const DropoutDetector detector(vp);
+    std::mt19937 rng(static_cast<unsigned>(fieldWidth));
+
+    SourceVideo::Data field = cleanField(vp, rng);
+    DropOuts none;
+    CHECK_EQ(detector.detect(field, none), 0);
+    CHECK_EQ(none.size(), 0);
+
+    // A flatline (carrier lost) and an excursion towards sync tip
+    const qint32 flatLine = 60;
+    const qint32 flatStart = vp.activeVideoStart + 101;
+    const qint32 flatEnd = flatStart + 40;
+    for (qint32 x = flatStart; x < flatEnd; x++) {
+        field[static_cast<size_t>(flatLine) * fieldWidth + x] = 30000;
+    }
+    const qint32 spikeLine = 120;
+    const qint32 spikeX = vp.activeVideoStart + 333;
+    field[static_cast<size_t>(spikeLine) * fieldWidth + spikeX] = 1000;
+
+    DropOuts found;
+    CHECK(detector.detect(field, found) >= 2);
+    // Field lines in DropOuts are 1-based; flat runs are found in whole
+    // blocks, so only the block-aligned inside of the run must be covered
+    const qint32 firstFlatBlock = vp.activeVideoStart +
+        ((flatStart - vp.activeVideoStart + BLOCK - 1) / BLOCK) * BLOCK;
+    CHECK(covered(found, flatLine + 1, firstFlatBlock, firstFlatBlock + 2 * BLOCK));
+    CHECK(covered(found, spikeLine + 1, spikeX, spikeX + 1));
+    for (qint32 i = 0; i < found.size(); i++) {
+        CHECK(found.startx(i) >= vp.activeVideoStart);
+        CHECK(found.endx(i) <= vp.activeVideoEnd);
+        CHECK(found.fieldLine(i) == flatLine + 1 || found.fieldLine(i) == spikeLine + 1);
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testScanBlockMatchesScalar();
+    testDetectField(NTSC_FIELD_WIDTH, NTSC_FIELD_HEIGHT);
+    testDetectField(PAL_FIELD_WIDTH, PAL_FIELD_HEIGHT);
+    testDetectField(1000, 280);
+    return testFailures() == 0 ? 0 : 1;
+}
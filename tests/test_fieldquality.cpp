@@ -0,0 +1,136 @@
+/******************************************************************************
+ * test_fieldquality.cpp
+ * vapoursynth-analog - Tests of noise-based field quality estimates
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "fieldquality.cpp"
+
+#include "testing.h"
+#include "testvideo.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// A field at black with Gaussian noise of the given RMS, and a ramp for
+// picture. Lines listed in dropoutLines have their back porch dropped out
+// to zero with spikes, as a dropout or head switch would.
+SourceVideo::Data noisyField(const LdDecodeMetaData::VideoParameters &vp, double rms,
+                             const std::vector<qint32> &dropoutLines, std::mt19937 &rng) {
+    std::normal_distribution<double> noise(0.0, rms);
+    SourceVideo::Data data(static_cast<size_t>(vp.fieldWidth) * vp.fieldHeight);
+    for (qint32 line = 0; line < vp.fieldHeight; line++) {
+        const bool dropout = std::find(dropoutLines.begin(), dropoutLines.end(), line)
+            != dropoutLines.end();
+        for (qint32 x = 0; x < vp.fieldWidth; x++) {
+            double level = vp.black16bIre;
+            if (x >= vp.activeVideoStart) {
+                level += (vp.white16bIre - vp.black16bIre) * (x - vp.activeVideoStart)
+                    / double(vp.fieldWidth - vp.activeVideoStart);
+            }
+            level += noise(rng);
+            if (dropout && x > vp.colourBurstEnd && x < vp.activeVideoStart) {
+                level = x % 7 == 0 ? 65535.0 : 0.0;
+            }
+            data[static_cast<size_t>(line) * vp.fieldWidth + x] =
+                static_cast<quint16>(std::clamp(std::round(level), 0.0, 65535.0));
+        }
+    }
+    return data;
+}
+
+// The vector sums against the scalar reference, for every count up to a
+// few vectors (so every tail length) and over the whole sample range,
+// including deviations beyond the clamp
+void testSumsMatchScalar() {
+    std::mt19937 rng(20240612);
+    std::uniform_int_distribution<int> anyLevel(0, 65535);
+    std::uniform_int_distribution<int> nearBlack(18048 - 3000, 18048 + 3000);
+    std::vector<quint16> samples(80);
+    for (int iteration = 0; iteration < 20000; iteration++) {
+        const bool extremes = iteration % 2 == 1;
+        for (quint16 &sample : samples) {
+            sample = static_cast<quint16>(extremes ? anyLevel(rng) : nearBlack(rng));
+        }
+        const quint16 offset = static_cast<quint16>(extremes ? anyLevel(rng) : 18048);
+        for (qint32 count = 0; count <= 72; count += 1 + iteration % 5) {
+            int64_t sum, sumSquares, scalarSum, scalarSquares;
+            sumDeviations(samples.data() + 3, count, offset, sum, sumSquares);
+            sumDeviationsScalar(samples.data() + 3, count, offset, scalarSum, scalarSquares);
+            CHECK_EQ(sum, scalarSum);
+            CHECK_EQ(sumSquares, scalarSquares);
+        }
+        if (testFailures() > 10) return;
+    }
+
+    // Deviations beyond the clamp count as the clamp
+    std::vector<quint16> high(16, 65535), low(16, 0);
+    int64_t sum, sumSquares;
+    sumDeviations(high.data(), 16, 0, sum, sumSquares);
+    CHECK_EQ(sum, 16 * MAX_DEVIATION);
+    sumDeviations(low.data(), 16, 65535, sum, sumSquares);
+    CHECK_EQ(sum, -16 * MAX_DEVIATION);
+    CHECK_EQ(sumSquares, 16 * MAX_DEVIATION * MAX_DEVIATION);
+}
+
+// Estimates follow the noise in a field, ranking a noisier capture of the
+// same field below a cleaner one as dropout correction does its sources, and
+// ignore the odd line whose porch dropped out
+void testRanking(qint32 fieldWidth, qint32 fieldHeight) {
+    const LdDecodeMetaData::VideoParameters vp = testParameters(fieldWidth, fieldHeight);
+    const FieldQualityEstimator estimator(vp);
+    std::mt19937 rng(static_cast<unsigned>(fieldWidth));
+    const double range = vp.white16bIre - vp.black16bIre;
+
+    double previous = 1000.0;
+    for (const double rms : {4.0, 30.0, 120.0, 500.0}) {
+        const double snr = estimator.estimate(noisyField(vp, rms, {}, rng));
+        // The median line's variance comes within a dB of the noise's
+        CHECK(std::abs(snr - 20.0 * std::log10(range / rms)) < 1.0);
+        CHECK(snr < previous);
+        previous = snr;
+    }
+
+    const std::vector<qint32> dropouts = {25, 60, 61, 62, 100};
+    const double clean = estimator.estimate(noisyField(vp, 30.0, dropouts, rng));
+    const double noisy = estimator.estimate(noisyField(vp, 120.0, {}, rng));
+    CHECK(std::abs(clean - 20.0 * std::log10(range / 30.0)) < 1.0);
+    CHECK(clean > noisy);
+
+    // Noiseless fields rank as very clean, not infinitely so
+    SourceVideo::Data flat(static_cast<size_t>(vp.fieldWidth) * vp.fieldHeight,
+                           static_cast<quint16>(vp.black16bIre));
+    CHECK(std::isfinite(estimator.estimate(flat)));
+
+    // The cache keeps the first estimate of a field
+    FieldQualityCache cache(vp, 4);
+    const SourceVideo::Data field = noisyField(vp, 30.0, {}, rng);
+    const double first = cache.quality(2, field);
+    CHECK_EQ(cache.quality(2, noisyField(vp, 500.0, {}, rng)), first);
+    CHECK(cache.quality(3, noisyField(vp, 500.0, {}, rng)) < first);
+}
+
+void testUnusableParameters() {
+    LdDecodeMetaData::VideoParameters vp = testParameters(NTSC_FIELD_WIDTH, NTSC_FIELD_HEIGHT);
+    vp.colourBurstEnd = vp.activeVideoStart - 10;
+    const SourceVideo::Data field(static_cast<size_t>(vp.fieldWidth) * vp.fieldHeight);
+    CHECK_EQ(FieldQualityEstimator(vp).estimate(field), -1.0);
+
+    vp = testParameters(NTSC_FIELD_WIDTH, NTSC_FIELD_HEIGHT);
+    const SourceVideo::Data shortField(static_cast<size_t>(vp.fieldWidth) * 10);
+    CHECK_EQ(FieldQualityEstimator(vp).estimate(shortField), -1.0);
+}
+
+} // anonymous namespace
+
+int main() {
+    testSumsMatchScalar();
+    testRanking(NTSC_FIELD_WIDTH, NTSC_FIELD_HEIGHT);
+    testRanking(PAL_FIELD_WIDTH, PAL_FIELD_HEIGHT);
+    testUnusableParameters();
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+ * test_halffloat.cpp
+ * vapoursynth-analog - Tests of float to half-precision conversion
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "halffloat.cpp"
+
+#include "testing.h"
+
+#include <vector>
+
+namespace {
+
+float floatFromBits(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint32_t bitsFromFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Exact float value of a half, NaN payloads moved to the float's top bits
+float halfToFloat(uint16_t half) {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    if (exponent == 0x1F) return floatFromBits(sign | 0x7F800000 | (mantissa << 13));
+    if (exponent != 0) return floatFromBits(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    if (mantissa == 0) return floatFromBits(sign);
+    // Subnormal half: normalize into the float's wider exponent range
+    uint32_t floatExponent = 113;
+    while (!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        floatExponent--;
+    }
+    return floatFromBits(sign | (floatExponent << 23) | ((mantissa & 0x3FF) << 13));
+}
+
+// The float halfway between a positive finite half and the next half up
+// (65536, for the largest finite half). It needs one more bit than a half
+// has, so it is exact.
+uint32_t halfwayBits(uint16_t half) {
+    const double low = halfToFloat(half);
+    const double high = half == 0x7BFF ? 65536.0 : halfToFloat(static_cast<uint16_t>(half + 1));
+    return bitsFromFloat(static_cast<float>((low + high) / 2.0));
+}
+
+bool isHalfNaN(uint16_t half) {
+    return (half & 0x7C00) == 0x7C00 && (half & 0x3FF) != 0;
+}
+
+// Every half, converted back from its exact float value. NaNs come back
+// quieted with their payload; everything else comes back unchanged.
+void testEveryHalfRoundTrips() {
+    for (uint32_t half = 0; half <= 0xFFFF; half++) {
+        const uint16_t converted = floatToHalf(halfToFloat(static_cast<uint16_t>(half)));
+        if (isHalfNaN(static_cast<uint16_t>(half))) {
+            CHECK_EQ(converted, half | 0x200);
+        } else {
+            CHECK_EQ(converted, half);
+        }
+        if (testFailures() > 10) return;
+    }
+}
+
+// Floats halfway between neighbouring halves round to the even one, and
+// the floats either side of halfway to the nearer one
+void testHalfwayRounding() {
+    for (uint32_t half = 0; half < 0x7C00; half++) {
+        const uint32_t halfway = halfwayBits(static_cast<uint16_t>(half));
+        const uint32_t even = (half & 1) ? half + 1 : half;
+        CHECK_EQ(floatToHalf(floatFromBits(halfway)), even);
+        CHECK_EQ(floatToHalf(floatFromBits(halfway - 1)), half);
+        CHECK_EQ(floatToHalf(floatFromBits(halfway + 1)), half + 1);
+        CHECK_EQ(floatToHalf(floatFromBits(0x80000000 | halfway)), even | 0x8000);
+        if (testFailures() > 10) return;
+    }
+}
+
+// Floats exercising every branch of the scalar conversion: each half's
+// exact value, the floats around the halfway points between halves, float
+// subnormals, values beyond the half range, infinities and NaN payloads
+std::vector<float> conversionInputs() {
+    std::vector<float> inputs;
+    for (uint32_t half = 0; half <= 0xFFFF; half++) {
+        const float value = halfToFloat(static_cast<uint16_t>(half));
+        inputs.push_back(value);
+        if ((half & 0x7FFF) >= 0x7C00) continue;
+
+        const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        const uint32_t halfway = halfwayBits(static_cast<uint16_t>(half & 0x7FFF));
+        for (const uint32_t bits : { halfway - 1, halfway, halfway + 1 }) {
+            inputs.push_back(floatFromBits(sign | bits));
+        }
+    }
+    for (const uint32_t sign : { 0x00000000u, 0x80000000u }) {
+        for (const uint32_t bits : { 0x00000001u, 0x00400000u, 0x007FFFFFu,
+                                     0x33000000u, 0x33000001u, 0x337FFFFFu,
+                                     0x477FEFFFu, 0x477FF000u, 0x47800000u,
+                                     0x7F7FFFFFu, 0x7F800000u, 0x7F800001u,
+                                     0x7FA00000u, 0x7FC00000u, 0x7FFFFFFFu }) {
+            inputs.push_back(floatFromBits(sign | bits));
+        }
+    }
+    return inputs;
+}
+
+// The vector converter selected for this CPU against the scalar one over
+// all inputs, and floatToHalfRow over every row length up to a few vectors
+// (so every tail length) at every alignment
+void testRowsMatchScalar() {
+    const std::vector<float> inputs = conversionInputs();
+    std::vector<uint16_t> expected(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        expected[i] = floatToHalf(inputs[i]);
+    }
+
+    std::vector<uint16_t> converted(inputs.size());
+    selectRowConverter()(inputs.data(), converted.data(), static_cast<int>(inputs.size()));
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (converted[i] != expected[i]) {
+            std::fprintf(stderr, "float %08x: vector 0x%04x, scalar 0x%04x\n",
+                         bitsFromFloat(inputs[i]), converted[i], expected[i]);
+            testFailures()++;
+            if (testFailures() > 10) return;
+        }
+    }
+
+    for (int offset = 0; offset < 8; offset++) {
+        for (int count = 0; count <= 40; count++) {
+            std::vector<uint16_t> row(count + 1, 0xDEAD);
+            floatToHalfRow(inputs.data() + offset * 997, row.data(), count);
+            for (int x = 0; x < count; x++) {
+                CHECK_EQ(row[x], expected[offset * 997 + x]);
+            }
+            // Nothing is written past the row
+            CHECK_EQ(row[count], 0xDEAD);
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testEveryHalfRoundTrips();
+    testHalfwayRounding();
+    testRowsMatchScalar();
+    return testFailures() == 0 ? 0 : 1;
+}
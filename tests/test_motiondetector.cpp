@@ -0,0 +1,135 @@
+/******************************************************************************
+ * test_motiondetector.cpp
+ * vapoursynth-analog - Tests of block motion detection for motion_skip
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#include "motiondetector.cpp"
+
+#include "testing.h"
+#include "testvideo.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// A field of a ramp with colour (a subcarrier whose phase flips from one
+// frame to the next, as NTSC's does) and a little noise, plus a bright box
+// at boxX on lines [boxTop, boxTop + 40)
+SourceVideo::Data field(const LdDecodeMetaData::VideoParameters &vp, int frame, qint32 boxX,
+                        qint32 boxTop, std::mt19937 &rng) {
+    static const int phaseSigns[4] = {0, 1, 0, -1};
+    std::uniform_int_distribution<int> noise(-60, 60);
+    const double ire = (vp.white16bIre - vp.black16bIre) / 100.0;
+    const int sign = frame % 2 == 0 ? 1 : -1;
+    SourceVideo::Data data(static_cast<size_t>(vp.fieldWidth) * vp.fieldHeight);
+    for (qint32 line = 0; line < vp.fieldHeight; line++) {
+        for (qint32 x = 0; x < vp.fieldWidth; x++) {
+            double level = 10.0 + 60.0 * x / vp.fieldWidth
+                         + sign * 30.0 * phaseSigns[x % 4];
+            if (line >= boxTop && line < boxTop + 40 && x >= boxX && x < boxX + 80) {
+                level = 95.0;
+            }
+            const double sample = vp.black16bIre + level * ire + noise(rng);
+            data[static_cast<size_t>(line) * vp.fieldWidth + x] =
+                static_cast<quint16>(std::clamp(sample, 0.0, 65535.0));
+        }
+    }
+    return data;
+}
+
+// The vector SAD against the scalar reference, on blocks ranging from
+// equal to entirely unrelated, including the extremes of the sample range
+void testBlockSadMatchesScalar() {
+    std::mt19937 rng(20240701);
+    std::uniform_int_distribution<int> anyLevel(0, 65535);
+    std::uniform_int_distribution<int> change(-2000, 2000);
+    std::uniform_int_distribution<int> choice(0, 4);
+    const ptrdiff_t stride = 37;
+    std::vector<quint16> current(stride * MotionDetector::BLOCK_LINES);
+    std::vector<quint16> previous(current.size());
+    for (int iteration = 0; iteration < 100000; iteration++) {
+        const int mode = choice(rng);
+        for (size_t i = 0; i < current.size(); i++) {
+            current[i] = static_cast<quint16>(anyLevel(rng));
+            switch (mode) {
+                case 0: previous[i] = current[i]; break;
+                case 1:
+                    previous[i] = static_cast<quint16>(std::clamp(current[i] + change(rng), 0, 65535));
+                    break;
+                case 2: previous[i] = static_cast<quint16>(65535 - current[i]); break;
+                case 3:
+                    current[i] = (i % 2) ? 65535 : 0;
+                    previous[i] = (i % 2) ? 0 : 65535;
+                    break;
+                default: previous[i] = static_cast<quint16>(anyLevel(rng)); break;
+            }
+        }
+        for (const ptrdiff_t offset : {ptrdiff_t(0), ptrdiff_t(5)}) {
+            CHECK_EQ(blockSad(current.data() + offset, previous.data() + offset, stride),
+                     blockSadScalar(current.data() + offset, previous.data() + offset, stride));
+        }
+        if (testFailures() > 10) return;
+    }
+}
+
+// Static pictures don't move despite their chroma's phase flip; a box
+// moving between frames moves only the rows it covers
+void testDetectMotion(qint32 fieldWidth, qint32 fieldHeight) {
+    const LdDecodeMetaData::VideoParameters vp = testParameters(fieldWidth, fieldHeight);
+    const MotionDetector detector(vp);
+    CHECK(detector.getBlockRows() > 4);
+    CHECK(detector.getBlocksAcross() > 10);
+    CHECK_EQ(detector.getFirstFrameLine(), vp.firstActiveFrameLine);
+    std::mt19937 rng(static_cast<unsigned>(fieldWidth));
+
+    const qint32 boxTop = vp.firstActiveFrameLine / 2 + 2 * MotionDetector::BLOCK_LINES;
+    SourceVideo::Data previous[2];
+    SourceVideo::Data still[2];
+    SourceVideo::Data moved[2];
+    for (int f = 0; f < 2; f++) {
+        previous[f] = field(vp, 0, vp.activeVideoStart + 100, boxTop, rng);
+        still[f] = field(vp, 1, vp.activeVideoStart + 100, boxTop, rng);
+        moved[f] = field(vp, 1, vp.activeVideoStart + 300, boxTop, rng);
+    }
+    const SourceVideo::Data *const previousFields[2] = {&previous[0], &previous[1]};
+
+    std::vector<int> movingPerRow;
+    const SourceVideo::Data *const stillFields[2] = {&still[0], &still[1]};
+    CHECK(detector.detect(stillFields, previousFields, movingPerRow));
+    CHECK_EQ(static_cast<int>(movingPerRow.size()), detector.getBlockRows());
+    for (const int moving : movingPerRow) {
+        CHECK_EQ(moving, 0);
+    }
+
+    const SourceVideo::Data *const movedFields[2] = {&moved[0], &moved[1]};
+    CHECK(detector.detect(movedFields, previousFields, movingPerRow));
+    const int boxFirstRow = (boxTop - vp.firstActiveFrameLine / 2) / MotionDetector::BLOCK_LINES;
+    const int boxEndRow = boxFirstRow + 40 / MotionDetector::BLOCK_LINES;
+    for (int row = 0; row < detector.getBlockRows(); row++) {
+        if (row >= boxFirstRow && row < boxEndRow) {
+            // The box left 5 blocks and arrived in 5, in each field
+            CHECK(movingPerRow[row] >= 2 * 10);
+        } else {
+            CHECK_EQ(movingPerRow[row], 0);
+        }
+    }
+
+    // Fields too short to hold the block rows aren't compared
+    SourceVideo::Data shortField(static_cast<size_t>(vp.fieldWidth) * 10);
+    const SourceVideo::Data *const shortFields[2] = {&shortField, &shortField};
+    CHECK(!detector.detect(shortFields, previousFields, movingPerRow));
+}
+
+} // anonymous namespace
+
+int main() {
+    testBlockSadMatchesScalar();
+    testDetectMotion(NTSC_FIELD_WIDTH, NTSC_FIELD_HEIGHT);
+    testDetectMotion(PAL_FIELD_WIDTH, PAL_FIELD_HEIGHT);
+    testDetectMotion(1000, 280);
+    return testFailures() == 0 ? 0 : 1;
+}
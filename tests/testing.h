@@ -0,0 +1,42 @@
+/******************************************************************************
+ * testing.h
+ * vapoursynth-analog - Minimal checks for the unit test programs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef TESTING_H
+#define TESTING_H
+
+#include <cstdio>
+
+// Each test program runs its checks from main() and returns testFailures()
+// as its exit status, which meson's test runner reports.
+inline int &testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__,        \
+                         __LINE__, #condition);                                \
+            testFailures()++;                                                  \
+        }                                                                      \
+    } while (0)
+
+// Check equality, printing both values as integers on failure
+#define CHECK_EQ(actual, expected)                                             \
+    do {                                                                       \
+        const long long actualValue = static_cast<long long>(actual);          \
+        const long long expectedValue = static_cast<long long>(expected);      \
+        if (actualValue != expectedValue) {                                    \
+            std::fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n",         \
+                         __FILE__, __LINE__, #actual, actualValue,             \
+                         expectedValue);                                       \
+            testFailures()++;                                                  \
+        }                                                                      \
+    } while (0)
+
+#endif // TESTING_H
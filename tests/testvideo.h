@@ -0,0 +1,37 @@
+/******************************************************************************
+ * testvideo.h
+ * vapoursynth-analog - Video parameters of the fields the unit tests make
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ ******************************************************************************/
+
+#ifndef TESTVIDEO_H
+#define TESTVIDEO_H
+
+#include "fieldgeometry.h"
+#include "lddecodemetadata.h"
+
+// Video parameters for synthetic fields of the given size, laid out in
+// proportion to it like a real capture's: sync and burst, then active video
+// from about 15% of the line, with 20 lines of vertical blanking per field.
+// Levels are ld-decode's NTSC levels for every size.
+inline LdDecodeMetaData::VideoParameters testParameters(qint32 fieldWidth, qint32 fieldHeight) {
+    LdDecodeMetaData::VideoParameters vp;
+    vp.system = fieldWidth == PAL_FIELD_WIDTH ? PAL : NTSC;
+    vp.fieldWidth = fieldWidth;
+    vp.fieldHeight = fieldHeight;
+    vp.activeVideoStart = fieldWidth * 3 / 20;
+    vp.activeVideoEnd = fieldWidth - fieldWidth / 50;
+    vp.colourBurstStart = fieldWidth / 12;
+    vp.colourBurstEnd = fieldWidth / 10;
+    vp.white16bIre = 51200;
+    vp.black16bIre = 18048;
+    vp.firstActiveFieldLine = 20;
+    vp.lastActiveFieldLine = fieldHeight - 1;
+    vp.firstActiveFrameLine = 2 * vp.firstActiveFieldLine;
+    vp.lastActiveFrameLine = 2 * fieldHeight - 20;
+    vp.isValid = true;
+    return vp;
+}
+
+#endif // TESTVIDEO_H